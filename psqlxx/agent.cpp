@@ -0,0 +1,584 @@
+#include <psqlxx/agent.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <utility>
+
+#include <cxxopts.hpp>
+
+#include <psqlxx/db.hpp>
+#include <psqlxx/pq.hpp>
+
+
+using namespace psqlxx;
+using internal::FrameType;
+
+
+namespace {
+
+constexpr std::size_t FRAME_HEADER_SIZE = 5;
+// Larger lengths are taken for garbage, rather than allocated.
+constexpr std::size_t MAX_PAYLOAD_SIZE = std::size_t{1} << 30;
+constexpr std::size_t READ_SIZE = 64 * 1024;
+
+class FileDescriptor {
+    int m_fd;
+
+public:
+    explicit FileDescriptor(const int fd): m_fd(fd) {
+    }
+    FileDescriptor(FileDescriptor &&other) noexcept: m_fd(std::exchange(other.m_fd, -1)) {
+    }
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    ~FileDescriptor() {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    [[nodiscard]]
+    int Get() const {
+        return m_fd;
+    }
+
+    [[nodiscard]]
+    operator bool() const {
+        return m_fd >= 0;
+    }
+};
+
+[[nodiscard]]
+inline std::string getDefaultSocket() {
+    const auto *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir and *runtime_dir) {
+        return std::string{runtime_dir} + "/psqlxx-agent.sock";
+    }
+    return "/tmp/psqlxx-agent-" + std::to_string(geteuid()) + ".sock";
+}
+
+[[nodiscard]]
+bool makeAddress(const std::string &path, sockaddr_un &address) {
+    address = {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Agent socket path is too long: '" << path << "'." << std::endl;
+        return false;
+    }
+
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    return true;
+}
+
+[[nodiscard]]
+inline bool connectTo(const int fd, const sockaddr_un &address) {
+    return connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+}
+
+[[nodiscard]]
+bool writeAll(const int fd, std::string_view data) {
+    while (not data.empty()) {
+        // A peer gone away fails the write, rather than raising SIGPIPE.
+        const auto written = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(written);
+    }
+
+    return true;
+}
+
+/**
+ * @return  The number of bytes read, 0 at the end of the stream, or negative on error.
+ */
+[[nodiscard]]
+ssize_t readSome(const int fd, std::string &buffer) {
+    ssize_t read_size = 0;
+    do {
+        read_size = read(fd, buffer.data(), buffer.size());
+    } while (read_size < 0 and errno == EINTR);
+    return read_size;
+}
+
+[[nodiscard]]
+bool isPeerSameUser(const int fd) {
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 and
+           credentials.uid == geteuid();
+}
+
+
+/**
+ * Sends what is written to it to the client as frames of one type, whenever it is full
+ * or flushed. Once sending has failed, the rest is discarded.
+ */
+class FrameBuffer : public std::streambuf {
+    const int m_fd;
+    const FrameType m_type;
+    // Shared by the output and error buffers, whose frames must not interleave.
+    std::mutex &m_socket_mutex;
+    std::string m_buffer;
+    bool m_failed = false;
+
+    bool sendBuffered() {
+        const std::string_view data{pbase(), static_cast<std::size_t>(pptr() - pbase())};
+        if (not data.empty() and not m_failed) {
+            const std::lock_guard lock{m_socket_mutex};
+            m_failed = not writeAll(m_fd, internal::encodeFrame(m_type, data));
+        }
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return not m_failed;
+    }
+
+protected:
+    int_type overflow(const int_type ch) override {
+        if (not sendBuffered()) {
+            return traits_type::eof();
+        }
+        if (not traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        return sendBuffered() ? 0 : -1;
+    }
+
+public:
+    FrameBuffer(const int fd, const FrameType type, std::mutex &socket_mutex):
+        m_fd(fd), m_type(type), m_socket_mutex(socket_mutex), m_buffer(READ_SIZE, '\0') {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+};
+
+
+int g_stop_fds[2] = {-1, -1};
+const DbProxy *g_agent_proxy = nullptr;
+
+extern "C" void stopAgent(int) {
+    // The statement of the current client is cancelled, and no further client is accepted.
+    (void) g_agent_proxy->CancelStatement();
+
+    const auto saved_errno = errno;
+    (void) !write(g_stop_fds[1], "", 1);
+    errno = saved_errno;
+}
+
+/**
+ * Waits until fd can be read, or the agent is stopped.
+ *
+ * @return  false if the agent has been stopped, or failed to wait.
+ */
+[[nodiscard]]
+bool waitToRead(const int fd) {
+    pollfd fds[] = {{fd, POLLIN, 0}, {g_stop_fds[0], POLLIN, 0}};
+    while (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) {
+            std::cerr << "Failed to wait for the client: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    // The stop byte is left in the pipe, for the accept loop to see as well.
+    return fds[1].revents == 0;
+}
+
+/**
+ * Runs the commands of a client until it disconnects or the agent is stopped, with the
+ * output of proxy and std::cerr sent to it. A client whose hello does not match settings
+ * is refused.
+ */
+void serveClient(const DbProxy &proxy, const int client, const std::string &settings) {
+    std::mutex socket_mutex;
+    FrameBuffer output{client, FrameType::output, socket_mutex};
+    FrameBuffer error{client, FrameType::error, socket_mutex};
+    auto *const previous_output = proxy.SetOutput(&output);
+    auto *const previous_error = std::cerr.rdbuf(&error);
+
+    internal::FrameDecoder decoder;
+    std::string buffer(READ_SIZE, '\0');
+    auto connected = true;
+    auto greeted = false;
+    while (connected and waitToRead(client)) {
+        const auto read_size = readSome(client, buffer);
+        if (read_size <= 0) {
+            break;
+        }
+
+        decoder.Feed({buffer.data(), static_cast<std::size_t>(read_size)});
+        while (connected) {
+            const auto a_frame = decoder.Next();
+            if (not a_frame) {
+                break;
+            }
+
+            auto succeeded = false;
+            if (not greeted) {
+                greeted = a_frame->type == FrameType::hello and a_frame->payload == settings;
+                succeeded = greeted;
+                if (not greeted) {
+                    std::cerr << "The agent is connected to another server, database or role, "
+                              "or formats output differently. Run without --use-agent, or "
+                              "start an agent for these options with --agent-socket." << std::endl;
+                }
+            } else if (a_frame->type == FrameType::query) {
+                succeeded = proxy.DoTransaction(a_frame->payload);
+            } else {
+                std::cerr << "Unexpected frame from the client." << std::endl;
+            }
+
+            output.pubsync();
+            error.pubsync();
+            const std::lock_guard lock{socket_mutex};
+            connected = writeAll(client, internal::encodeFrame(FrameType::done,
+                                                               succeeded ? "1" : "0")) and greeted;
+        }
+        connected = connected and not decoder.Failed();
+    }
+
+    proxy.SetOutput(previous_output);
+    std::cerr.rdbuf(previous_error);
+
+    // The next client starts from a clean session, whatever this one has set or left open.
+    if (not proxy.ResetSession()) {
+        std::cerr << "Failed to reset the session after a client." << std::endl;
+    }
+}
+
+/**
+ * Listens on path, replacing a socket left behind by an agent which is not running anymore.
+ *
+ * @return  An invalid descriptor after printing the error, if failed.
+ */
+[[nodiscard]]
+FileDescriptor listenOn(const std::string &path) {
+    sockaddr_un address{};
+    if (not makeAddress(path, address)) {
+        return FileDescriptor{-1};
+    }
+
+    FileDescriptor listener{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (not listener) {
+        std::cerr << "Failed to create the agent socket: " << strerror(errno) << std::endl;
+        return listener;
+    }
+
+    struct stat file_status {};
+    if (lstat(path.c_str(), &file_status) == 0 and S_ISSOCK(file_status.st_mode)) {
+        const FileDescriptor probe{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+        if (probe and connectTo(probe.Get(), address)) {
+            std::cerr << "An agent is already serving '" << path << "'." << std::endl;
+            return FileDescriptor{-1};
+        }
+        (void) unlink(path.c_str());
+    }
+
+    // Only this user may connect, which isPeerSameUser() checks once more.
+    const auto previous_mask = umask(0077);
+    const auto bound = bind(listener.Get(), reinterpret_cast<const sockaddr *>(&address),
+                            sizeof(address)) == 0;
+    umask(previous_mask);
+    if (not bound or listen(listener.Get(), SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on '" << path << "': " << strerror(errno) << std::endl;
+        return FileDescriptor{-1};
+    }
+
+    return listener;
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::string encodeFrame(const FrameType type, const std::string_view payload) {
+    assert(payload.size() <= MAX_PAYLOAD_SIZE);
+
+    std::string a_frame;
+    a_frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    a_frame.push_back(static_cast<char>(type));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        a_frame.push_back(static_cast<char>((payload.size() >> shift) & 0xff));
+    }
+    a_frame.append(payload);
+
+    return a_frame;
+}
+
+std::optional<Frame> FrameDecoder::Next() {
+    if (m_failed or m_buffer.size() < FRAME_HEADER_SIZE) {
+        return std::nullopt;
+    }
+
+    const auto type = static_cast<FrameType>(m_buffer[0]);
+    std::size_t length = 0;
+    for (std::size_t i = 1; i < FRAME_HEADER_SIZE; ++i) {
+        length = (length << 8) | static_cast<unsigned char>(m_buffer[i]);
+    }
+    if (length > MAX_PAYLOAD_SIZE or
+        (type != FrameType::hello and type != FrameType::query and type != FrameType::output and
+         type != FrameType::error and type != FrameType::done)) {
+        m_failed = true;
+        return std::nullopt;
+    }
+
+    if (m_buffer.size() < FRAME_HEADER_SIZE + length) {
+        return std::nullopt;
+    }
+
+    Frame a_frame{type, m_buffer.substr(FRAME_HEADER_SIZE, length)};
+    m_buffer.erase(0, FRAME_HEADER_SIZE + length);
+    return a_frame;
+}
+
+std::string describeAgentSettings(const DbProxyOptions &options) {
+    char *error = nullptr;
+    const pq::ConninfoPtr parameters{
+        PQconninfoParse(options.connection_options.base_connection_string.c_str(), &error)};
+    PQfreemem(error);
+    const pq::ConninfoPtr defaults{PQconndefaults()};
+
+    const auto find_value = [](const PQconninfoOption *an_option, const std::string_view keyword) {
+        for (; an_option and an_option->keyword; ++an_option) {
+            if (an_option->keyword == keyword) {
+                return an_option->val;
+            }
+        }
+        return static_cast<char *>(nullptr);
+    };
+
+    std::string settings;
+    for (const auto keyword : {"service", "host", "hostaddr", "port", "dbname", "user",
+                               "options", "target_session_attrs"}) {
+        const auto *value = find_value(parameters.get(), keyword);
+        if (not value) {
+            value = find_value(defaults.get(), keyword);
+        }
+        settings.append(keyword).append("=").append(value ? value : "").append("\n");
+    }
+
+    const auto &format_options = options.format_options;
+    settings.append("csv=").append(format_options.csv ? "1" : "0").append("\n");
+    settings.append("no_align=").append(format_options.no_align ? "1" : "0").append("\n");
+    settings.append("title_and_summary=").append(format_options.show_title_and_summary ?
+                                                  "1" : "0").append("\n");
+    settings.append("delimiter=").append(format_options.delimiter).append("\n");
+
+    return settings;
+}
+
+}//namespace internal
+
+
+void AddAgentOptions(cxxopts::Options &options) {
+    options.add_options("Agent")
+    ("agent",
+     "keep the connection and type map warm, serving the -c commands of invocations with --use-agent",
+     cxxopts::value<bool>()->default_value("false"))
+    ("use-agent",
+     "run -c commands through the --agent of this user, connecting directly if none is running; the agent refuses them unless connected and formatting the same way",
+     cxxopts::value<bool>()->default_value("false"))
+    ("agent-socket",
+     "Unix socket of the agent, psqlxx-agent.sock in $XDG_RUNTIME_DIR by default, or in /tmp",
+     cxxopts::value<std::string>()->default_value(""), "PATH")
+    ;
+}
+
+AgentOptions HandleAgentOptions(const cxxopts::ParseResult &parsed_options) {
+    AgentOptions options{};
+
+    options.serve = parsed_options["agent"].as<bool>();
+    options.use = parsed_options["use-agent"].as<bool>();
+    options.socket = parsed_options["agent-socket"].as<std::string>();
+    if (options.socket.empty()) {
+        options.socket = getDefaultSocket();
+    }
+
+    return options;
+}
+
+bool RunAgent(const DbProxy &proxy) {
+    const auto &path = proxy.GetOptions().agent_options.socket;
+    const auto settings = internal::describeAgentSettings(proxy.GetOptions());
+
+    const auto listener = listenOn(path);
+    if (not listener) {
+        return false;
+    }
+
+    if (pipe2(g_stop_fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::cerr << "Failed to create the agent stop pipe: " << strerror(errno) << std::endl;
+        (void) unlink(path.c_str());
+        return false;
+    }
+    g_agent_proxy = &proxy;
+
+    struct sigaction stop_action {};
+    stop_action.sa_handler = stopAgent;
+    sigemptyset(&stop_action.sa_mask);
+    struct sigaction previous_int_action {};
+    struct sigaction previous_term_action {};
+    sigaction(SIGINT, &stop_action, &previous_int_action);
+    sigaction(SIGTERM, &stop_action, &previous_term_action);
+
+    std::cerr << "Agent serving '" << path << "'." << std::endl;
+
+    while (true) {
+        pollfd fds[] = {{listener.Get(), POLLIN, 0}, {g_stop_fds[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to wait for clients: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+
+        const FileDescriptor client{accept4(listener.Get(), nullptr, nullptr, SOCK_CLOEXEC)};
+        if (not client) {
+            continue;
+        }
+        if (not isPeerSameUser(client.Get())) {
+            std::cerr << "Rejected a client of another user." << std::endl;
+            continue;
+        }
+
+        serveClient(proxy, client.Get(), settings);
+    }
+
+    sigaction(SIGINT, &previous_int_action, nullptr);
+    sigaction(SIGTERM, &previous_term_action, nullptr);
+    g_agent_proxy = nullptr;
+    for (auto &fd : g_stop_fds) {
+        close(fd);
+        fd = -1;
+    }
+
+    (void) unlink(path.c_str());
+    return true;
+}
+
+bool CanRunThroughAgent(const DbProxyOptions &options) {
+    const std::pair<bool, std::string_view> unsupported_options[] = {
+        {not options.command_file.empty(), "--command-file"},
+        {options.fetch_count > 0, "--fetch-count"},
+        {options.binary_results, "--binary-results"},
+        {options.pipeline, "--pipeline"},
+        {options.batch_size > 1, "--batch-size"},
+        {options.jobs > 1, "--jobs"},
+        {options.statement_timeout_ms > 0, "--statement-timeout"},
+        {options.timing, "--timing"},
+        {not options.capture_file.empty(), "--capture"},
+        {not options.metrics_file.empty(), "--metrics-file"},
+        {not options.copy_format.empty(), "--copy-format"},
+        {not options.format_options.out_file.empty(), "--out-file"},
+        {options.format_options.realign_each_batch, "--realign-batches"},
+    };
+    for (const auto &[is_set, name] : unsupported_options) {
+        if (is_set) {
+            std::cerr << "--use-agent cannot be combined with " << name <<
+                      ", which the agent does not honour." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<bool> RunThroughAgent(const DbProxyOptions &options) {
+    const auto &socket_path = options.agent_options.socket;
+    sockaddr_un address{};
+    if (not makeAddress(socket_path, address)) {
+        return std::nullopt;
+    }
+
+    const FileDescriptor agent{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    if (not agent or not connectTo(agent.Get(), address)) {
+        return std::nullopt;
+    }
+    // Otherwise another user could listen on the socket, to read the commands.
+    if (not isPeerSameUser(agent.Get())) {
+        std::cerr << "Ignored the agent socket '" << socket_path <<
+                  "' of another user." << std::endl;
+        return std::nullopt;
+    }
+
+    // The hello is answered like a command, which fails if the agent refuses the client.
+    std::vector<std::string> frames{
+        internal::encodeFrame(FrameType::hello, internal::describeAgentSettings(options))};
+    for (const auto &a_command : options.commands) {
+        frames.push_back(internal::encodeFrame(FrameType::query, a_command));
+    }
+
+    internal::FrameDecoder decoder;
+    std::string buffer(READ_SIZE, '\0');
+    for (const auto &a_frame_to_send : frames) {
+        if (not writeAll(agent.Get(), a_frame_to_send)) {
+            std::cerr << "Failed to send the command to the agent: " << strerror(errno) <<
+                      std::endl;
+            return false;
+        }
+
+        std::optional<bool> succeeded;
+        while (not succeeded) {
+            const auto a_frame = decoder.Next();
+            if (not a_frame) {
+                const auto read_size = decoder.Failed() ? 0 : readSome(agent.Get(), buffer);
+                if (read_size <= 0) {
+                    std::cerr << "Lost the connection to the agent." << std::endl;
+                    return false;
+                }
+                decoder.Feed({buffer.data(), static_cast<std::size_t>(read_size)});
+                continue;
+            }
+
+            switch (a_frame->type) {
+                case FrameType::output:
+                    std::cout.write(a_frame->payload.data(), a_frame->payload.size());
+                    break;
+                case FrameType::error:
+                    std::cerr.write(a_frame->payload.data(), a_frame->payload.size());
+                    break;
+                case FrameType::done:
+                    succeeded = a_frame->payload == "1";
+                    break;
+                default:
+                    std::cerr << "Unexpected frame from the agent." << std::endl;
+                    return false;
+            }
+        }
+
+        std::cout.flush();
+        if (not *succeeded) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace cxxopts {
+
+class Options;
+class ParseResult;
+
+}
+
+
+namespace psqlxx {
+
+class DbProxy;
+struct DbProxyOptions;
+
+
+struct AgentOptions {
+    // Serve the -c commands of other invocations over the socket
+    bool serve = false;
+
+    // Run the -c commands through an agent serving the socket, if any
+    bool use = false;
+
+    std::string socket;
+};
+
+void AddAgentOptions(cxxopts::Options &options);
+
+[[nodiscard]]
+AgentOptions HandleAgentOptions(const cxxopts::ParseResult &parsed_options);
+
+
+/**
+ * Keeps the connection of proxy, and its type map, warm, and runs the commands of clients
+ * connecting to the agent socket, one client at a time, streaming their output back.
+ * Clients of other users are rejected. The session is reset after each client.
+ *
+ * @note    The output is formatted with the options the agent was started with.
+ *
+ * @return  false if failed to listen; otherwise true once SIGINT or SIGTERM is received.
+ */
+[[nodiscard]]
+bool RunAgent(const DbProxy &proxy);
+
+/**
+ * @return  false after printing the error, if options ask for anything the agent cannot
+ *          honour, as it runs each command its own way, on its own connection.
+ */
+[[nodiscard]]
+bool CanRunThroughAgent(const DbProxyOptions &options);
+
+/**
+ * Runs the -c commands of options, in order, through the agent serving its socket,
+ * printing their output, until one of them fails. The agent refuses to run them unless
+ * it is connected to the same server, database and role, and formats output the same way.
+ *
+ * @return  nullopt if no agent of this user is serving the socket; otherwise whether all
+ *          commands succeeded.
+ */
+[[nodiscard]]
+std::optional<bool> RunThroughAgent(const DbProxyOptions &options);
+
+namespace internal {
+
+/**
+ * A frame is its type, the length of its payload as 4 bytes in network order, and the payload.
+ * Clients send a query frame per command, and the agent answers with output and error frames,
+ * then a done frame whose payload is "1" if the command succeeded, or "0".
+ */
+enum class FrameType : char {
+    // Sent first by the client, with its describeAgentSettings()
+    hello = 'H',
+    query = 'Q',
+    output = 'O',
+    error = 'E',
+    done = 'Z',
+};
+
+struct Frame {
+    FrameType type;
+    std::string payload;
+};
+
+[[nodiscard]]
+std::string encodeFrame(const FrameType type, const std::string_view payload);
+
+/**
+ * @return  The server, database and role which the connection options of options lead to,
+ *          with the defaults libpq takes from the environment, and the output format.
+ *          An agent runs the commands of clients whose description matches its own only.
+ */
+[[nodiscard]]
+std::string describeAgentSettings(const DbProxyOptions &options);
+
+/**
+ * Splits the bytes read from a socket into frames.
+ */
+class FrameDecoder {
+    std::string m_buffer;
+    bool m_failed = false;
+
+public:
+    void Feed(const std::string_view data) {
+        m_buffer.append(data);
+    }
+
+    /**
+     * @return  nullopt if no whole frame has been fed, or if the data is invalid.
+     */
+    [[nodiscard]]
+    std::optional<Frame> Next();
+
+    [[nodiscard]]
+    bool Failed() const {
+        return m_failed;
+    }
+};
+
+}//namespace internal
+
+}//namespace psqlxx
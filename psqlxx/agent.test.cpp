@@ -0,0 +1,105 @@
+#include <psqlxx/agent.hpp>
+#include <psqlxx/db.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace psqlxx::internal;
+
+
+TEST(AgentTests, CanEncodeFrame) {
+    using namespace std::string_literals;
+    ASSERT_EQ("Q\0\0\0\x08SELECT 1"s, encodeFrame(FrameType::query, "SELECT 1"));
+    ASSERT_EQ("Z\0\0\0\0"s, encodeFrame(FrameType::done, ""));
+}
+
+TEST(AgentTests, CanDecodeFramesFedInPieces) {
+    const auto data = encodeFrame(FrameType::output, "a row\n") +
+                      encodeFrame(FrameType::done, "1");
+
+    FrameDecoder decoder;
+    decoder.Feed(std::string_view{data}.substr(0, 3));
+    ASSERT_FALSE(decoder.Next());
+    decoder.Feed(std::string_view{data}.substr(3, 7));
+    ASSERT_FALSE(decoder.Next());
+    decoder.Feed(std::string_view{data}.substr(10));
+
+    const auto first_frame = decoder.Next();
+    ASSERT_TRUE(first_frame);
+    ASSERT_EQ(FrameType::output, first_frame->type);
+    ASSERT_EQ("a row\n", first_frame->payload);
+
+    const auto second_frame = decoder.Next();
+    ASSERT_TRUE(second_frame);
+    ASSERT_EQ(FrameType::done, second_frame->type);
+    ASSERT_EQ("1", second_frame->payload);
+
+    ASSERT_FALSE(decoder.Next());
+    ASSERT_FALSE(decoder.Failed());
+}
+
+TEST(AgentTests, CanDecodeLargeFrame) {
+    const std::string payload(100000, 'x');
+
+    FrameDecoder decoder;
+    decoder.Feed(encodeFrame(FrameType::error, payload));
+
+    const auto a_frame = decoder.Next();
+    ASSERT_TRUE(a_frame);
+    ASSERT_EQ(payload, a_frame->payload);
+}
+
+TEST(AgentTests, DecoderFailsOnUnknownFrameType) {
+    using namespace std::string_literals;
+    FrameDecoder decoder;
+    decoder.Feed("X\0\0\0\0"s);
+
+    ASSERT_FALSE(decoder.Next());
+    ASSERT_TRUE(decoder.Failed());
+}
+
+TEST(AgentTests, DecoderFailsOnHugeLength) {
+    using namespace std::string_literals;
+    FrameDecoder decoder;
+    decoder.Feed("O\xff\xff\xff\xff"s);
+
+    ASSERT_FALSE(decoder.Next());
+    ASSERT_TRUE(decoder.Failed());
+}
+
+TEST(AgentTests, RunThroughAgentReturnsNulloptWithoutAgent) {
+    DbProxyOptions options{ConnectionOptions{}, FormatterOptions{}};
+    options.agent_options.socket = testing::TempDir() + "psqlxx_no_agent.sock";
+    options.commands = {"SELECT 1"};
+
+    ASSERT_FALSE(RunThroughAgent(options));
+}
+
+TEST(AgentTests, SettingsDifferByDatabaseButNotPassword) {
+    DbProxyOptions options{ConnectionOptions{}, FormatterOptions{}};
+    options.connection_options.base_connection_string = "host=db1 dbname=app password=a";
+    const auto settings = describeAgentSettings(options);
+
+    options.connection_options.base_connection_string = "host=db1 dbname=app password=b";
+    ASSERT_EQ(settings, describeAgentSettings(options));
+
+    options.connection_options.base_connection_string = "postgresql://db1/staging";
+    ASSERT_NE(settings, describeAgentSettings(options));
+}
+
+TEST(AgentTests, SettingsDifferByOutputFormat) {
+    DbProxyOptions options{ConnectionOptions{}, FormatterOptions{}};
+    const auto settings = describeAgentSettings(options);
+    options.format_options.csv = true;
+
+    ASSERT_NE(settings, describeAgentSettings(options));
+}
+
+TEST(AgentTests, CannotRunThroughAgentWithPipeline) {
+    DbProxyOptions options{ConnectionOptions{}, FormatterOptions{}};
+    ASSERT_TRUE(CanRunThroughAgent(options));
+
+    options.pipeline = true;
+    ASSERT_FALSE(CanRunThroughAgent(options));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * Statements running in the background, numbered from 1 in the order they are started.
+ *
+ * @note    Not thread-safe; only the futures complete on other threads.
+ */
+template <typename Result>
+class BackgroundJobs {
+public:
+    struct Job {
+        std::size_t id = 0;
+        std::string sql;
+        std::future<Result> result;
+        std::chrono::steady_clock::time_point start;
+
+        [[nodiscard]]
+        bool Done() const {
+            return result.wait_for(std::chrono::seconds::zero()) == std::future_status::ready;
+        }
+    };
+
+private:
+    std::vector<Job> m_jobs;
+    std::size_t m_next_id = 1;
+
+public:
+    /**
+     * @return  The id of the job.
+     */
+    std::size_t Start(std::string sql, std::future<Result> result) {
+        m_jobs.push_back({m_next_id, std::move(sql), std::move(result),
+                          std::chrono::steady_clock::now()});
+        return m_next_id++;
+    }
+
+    [[nodiscard]]
+    bool Empty() const {
+        return m_jobs.empty();
+    }
+
+    [[nodiscard]]
+    std::size_t RunningCount() const {
+        std::size_t count = 0;
+        for (const auto &a_job : m_jobs) {
+            count += not a_job.Done();
+        }
+        return count;
+    }
+
+    /**
+     * Prints a line per job, with its id, state, seconds since it started and its statement.
+     */
+    void List(std::ostream &out) const {
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto &a_job : m_jobs) {
+            const std::chrono::duration<double> elapsed = now - a_job.start;
+            out << '[' << a_job.id << "] " << (a_job.Done() ? "done    " : "running ") <<
+                static_cast<std::size_t>(elapsed.count()) << "s\t" << a_job.sql << '\n';
+        }
+    }
+
+    /**
+     * Removes a job from the table, so that its result can be waited for.
+     *
+     * @param   id  of the job, or nullopt for the latest one.
+     * @return  nullopt if there is no such job.
+     */
+    [[nodiscard]]
+    std::optional<Job> Collect(const std::optional<std::size_t> id = std::nullopt) {
+        if (m_jobs.empty()) {
+            return std::nullopt;
+        }
+
+        auto a_job = std::prev(m_jobs.end());
+        if (id) {
+            for (a_job = m_jobs.begin(); a_job != m_jobs.end() and a_job->id != *id; ++a_job);
+            if (a_job == m_jobs.end()) {
+                return std::nullopt;
+            }
+        }
+
+        std::optional<Job> collected{std::move(*a_job)};
+        m_jobs.erase(a_job);
+        return collected;
+    }
+};
+
+}//namespace psqlxx
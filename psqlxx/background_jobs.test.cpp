@@ -0,0 +1,71 @@
+#include <psqlxx/background_jobs.hpp>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(BackgroundJobsTests, CanNumberJobsInOrder) {
+    BackgroundJobs<int> jobs;
+    std::promise<int> first_promise;
+    std::promise<int> second_promise;
+
+    ASSERT_EQ(1u, jobs.Start("SELECT 1", first_promise.get_future()));
+    ASSERT_EQ(2u, jobs.Start("SELECT 2", second_promise.get_future()));
+}
+
+TEST(BackgroundJobsTests, CanListRunningAndDoneJobs) {
+    BackgroundJobs<int> jobs;
+    std::promise<int> first_promise;
+    std::promise<int> second_promise;
+    jobs.Start("VACUUM", first_promise.get_future());
+    jobs.Start("SELECT 2", second_promise.get_future());
+    second_promise.set_value(2);
+
+    ASSERT_EQ(1u, jobs.RunningCount());
+
+    std::ostringstream out;
+    jobs.List(out);
+    ASSERT_EQ("[1] running 0s\tVACUUM\n[2] done    0s\tSELECT 2\n", out.str());
+}
+
+TEST(BackgroundJobsTests, CanCollectLatestJobByDefault) {
+    BackgroundJobs<int> jobs;
+    std::promise<int> first_promise;
+    std::promise<int> second_promise;
+    jobs.Start("SELECT 1", first_promise.get_future());
+    jobs.Start("SELECT 2", second_promise.get_future());
+    second_promise.set_value(2);
+
+    auto a_job = jobs.Collect();
+    ASSERT_TRUE(a_job);
+    ASSERT_EQ(2u, a_job->id);
+    ASSERT_EQ(2, a_job->result.get());
+    ASSERT_FALSE(jobs.Empty());
+}
+
+TEST(BackgroundJobsTests, CanCollectJobById) {
+    BackgroundJobs<int> jobs;
+    std::promise<int> first_promise;
+    std::promise<int> second_promise;
+    jobs.Start("SELECT 1", first_promise.get_future());
+    jobs.Start("SELECT 2", second_promise.get_future());
+    first_promise.set_exception(std::make_exception_ptr(std::runtime_error{"failed"}));
+
+    auto a_job = jobs.Collect(1);
+    ASSERT_TRUE(a_job);
+    ASSERT_EQ("SELECT 1", a_job->sql);
+    ASSERT_THROW(a_job->result.get(), std::runtime_error);
+
+    ASSERT_FALSE(jobs.Collect(1));
+    ASSERT_FALSE(jobs.Collect(3));
+}
+
+TEST(BackgroundJobsTests, CollectReturnsNulloptIfEmpty) {
+    BackgroundJobs<int> jobs;
+    ASSERT_TRUE(jobs.Empty());
+    ASSERT_FALSE(jobs.Collect());
+}
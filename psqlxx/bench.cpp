@@ -0,0 +1,381 @@
+#include <psqlxx/bench.hpp>
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include <psqlxx/db.hpp>
+#include <psqlxx/latency_histogram.hpp>
+#include <psqlxx/mapped_file.hpp>
+#include <psqlxx/pq.hpp>
+#include <psqlxx/sql_splitter.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+[[nodiscard]]
+inline std::string getStatementName(const std::size_t index) {
+    return "psqlxx_bench_" + std::to_string(index);
+}
+
+/**
+ * Appends the statements of script, split as by SqlSplitter, to statements.
+ *
+ * @return  false after printing the error, if script holds a command line.
+ */
+[[nodiscard]]
+bool addBenchStatements(const std::string_view script, std::vector<std::string> &statements) {
+    SqlSplitter splitter{script};
+    while (const auto a_statement = splitter.Next()) {
+        if (IsCommandLine(a_statement->text)) {
+            std::cerr << "Line " << a_statement->line <<
+                      ": Commands cannot run with --bench." << std::endl;
+            return false;
+        }
+        statements.emplace_back(a_statement->text);
+    }
+    return true;
+}
+
+/**
+ * @return  The statements of the -c commands or the -f file, or empty after printing the
+ *          error if there are none. A command holding several statements is split, as
+ *          PQprepare() takes one statement only.
+ */
+[[nodiscard]]
+std::vector<std::string> getBenchStatements(const DbProxyOptions &options) {
+    std::vector<std::string> statements;
+    for (const auto &a_command : options.commands) {
+        if (not addBenchStatements(a_command, statements)) {
+            return {};
+        }
+    }
+
+    if (not options.command_file.empty()) {
+        const MappedFile file{options.command_file};
+        if (not file or not addBenchStatements(file.View(), statements)) {
+            return {};
+        }
+    }
+
+    if (statements.empty()) {
+        std::cerr << "--bench needs statements to run, from -c or -f." << std::endl;
+    }
+    return statements;
+}
+
+struct Client {
+    pq::ConnectionPtr connection;
+
+    std::size_t next_statement = 0;
+    bool busy = false;
+    bool done = false;
+
+    bool transaction_failed = false;
+    std::size_t transaction_count = 0;
+    Clock::time_point transaction_start;
+};
+
+/**
+ * @return  Null after printing the error, if failed to connect or to prepare statements.
+ */
+[[nodiscard]]
+pq::ConnectionPtr connectClient(const std::string &connection_string,
+                                const std::vector<std::string> &statements) {
+    auto a_connection = pq::Connect(connection_string);
+    if (not a_connection) {
+        return {};
+    }
+
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        const pq::ResultPtr a_result{PQprepare(a_connection.get(), getStatementName(i).c_str(),
+                                               statements[i].c_str(), 0, nullptr)};
+        if (not pq::CheckResult(a_connection.get(), a_result.get())) {
+            return {};
+        }
+    }
+
+    // Non-blocking, so that one thread can drive many clients.
+    if (PQsetnonblocking(a_connection.get(), 1) != 0) {
+        std::cerr << PQerrorMessage(a_connection.get()) << std::endl;
+        return {};
+    }
+
+    return a_connection;
+}
+
+struct ThreadReport {
+    LatencyHistogram latencies;
+    std::size_t failed_count = 0;
+    // Clients whose connection broke, which run no more transactions
+    std::size_t lost_client_count = 0;
+};
+
+class ClientDriver {
+    const BenchOptions &m_options;
+    const std::size_t m_statement_count;
+    const Clock::time_point m_deadline;
+
+    ThreadReport &m_report;
+
+    void fail(Client &a_client) const {
+        std::cerr << PQerrorMessage(a_client.connection.get()) << std::endl;
+        a_client.connection.reset();
+        a_client.busy = false;
+        a_client.done = true;
+        ++m_report.lost_client_count;
+    }
+
+    [[nodiscard]]
+    bool finished(const Client &a_client) const {
+        return (m_options.transactions and a_client.transaction_count >= m_options.transactions) or
+               (m_options.seconds and Clock::now() >= m_deadline);
+    }
+
+    void send(Client &a_client) const {
+        if (a_client.next_statement == 0) {
+            if (finished(a_client)) {
+                a_client.done = true;
+                return;
+            }
+            a_client.transaction_start = Clock::now();
+            a_client.transaction_failed = false;
+        }
+
+        if (PQsendQueryPrepared(a_client.connection.get(),
+                                getStatementName(a_client.next_statement).c_str(),
+                                0, nullptr, nullptr, nullptr, 0) != 1) {
+            fail(a_client);
+            return;
+        }
+        a_client.busy = true;
+    }
+
+    void completeStatement(Client &a_client) const {
+        a_client.busy = false;
+        if (++a_client.next_statement < m_statement_count) {
+            return;
+        }
+
+        a_client.next_statement = 0;
+        ++a_client.transaction_count;
+        if (a_client.transaction_failed) {
+            ++m_report.failed_count;
+        } else {
+            const auto latency = Clock::now() - a_client.transaction_start;
+            m_report.latencies.Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+        }
+    }
+
+    void receive(Client &a_client) const {
+        while (a_client.busy and not PQisBusy(a_client.connection.get())) {
+            const pq::ResultPtr a_result{PQgetResult(a_client.connection.get())};
+            if (not a_result) {
+                completeStatement(a_client);
+                break;
+            }
+
+            const auto status = PQresultStatus(a_result.get());
+            if (status != PGRES_TUPLES_OK and status != PGRES_COMMAND_OK) {
+                // Later statements still run, a failed transaction block ends at its COMMIT.
+                if (not a_client.transaction_failed) {
+                    (void) pq::CheckResult(a_client.connection.get(), a_result.get());
+                }
+                a_client.transaction_failed = true;
+            }
+        }
+    }
+
+public:
+    ClientDriver(const BenchOptions &options, const std::size_t statement_count,
+                 const Clock::time_point deadline, ThreadReport &report):
+        m_options(options),
+        m_statement_count(statement_count),
+        m_deadline(deadline),
+        m_report(report) {
+    }
+
+    /**
+     * Keeps a statement in flight on each client, until all of them are finished.
+     */
+    void Run(std::vector<Client *> &clients) const {
+        std::vector<pollfd> socket_fds;
+        std::vector<Client *> busy_clients;
+        while (true) {
+            socket_fds.clear();
+            busy_clients.clear();
+            for (auto *const a_client : clients) {
+                if (not a_client->done and not a_client->busy) {
+                    send(*a_client);
+                }
+                if (not a_client->busy) {
+                    continue;
+                }
+
+                const auto flush_result = PQflush(a_client->connection.get());
+                if (flush_result < 0) {
+                    fail(*a_client);
+                    continue;
+                }
+                pollfd socket_fd{PQsocket(a_client->connection.get()), POLLIN, 0};
+                if (flush_result > 0) {
+                    socket_fd.events |= POLLOUT;
+                }
+                socket_fds.push_back(socket_fd);
+                busy_clients.push_back(a_client);
+            }
+            if (socket_fds.empty()) {
+                return;
+            }
+
+            if (poll(socket_fds.data(), socket_fds.size(), -1) < 0 and errno != EINTR) {
+                std::cerr << "Failed to poll client connections: " << std::strerror(errno) <<
+                          std::endl;
+                return;
+            }
+
+            for (std::size_t i = 0; i < socket_fds.size(); ++i) {
+                auto &a_client = *busy_clients[i];
+                if ((socket_fds[i].revents & (POLLIN | POLLERR | POLLHUP)) and
+                    not PQconsumeInput(a_client.connection.get())) {
+                    fail(a_client);
+                    continue;
+                }
+                receive(a_client);
+            }
+        }
+    }
+};
+
+[[nodiscard]]
+inline double toMilliseconds(const LatencyHistogram::ValueType microseconds) {
+    return microseconds / 1000.0;
+}
+
+void printReport(const BenchOptions &options, const std::size_t statement_count,
+                 const LatencyHistogram &latencies, const std::size_t failed_count,
+                 const std::size_t lost_client_count, const Clock::duration elapsed) {
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+
+    std::cout << std::fixed << std::setprecision(3) <<
+              "clients: " << options.clients << ", threads: " << options.threads <<
+              ", statements per transaction: " << statement_count << '\n' <<
+              "transactions: " << latencies.Count() << " succeeded, " << failed_count <<
+              " failed in " << seconds << " s\n" <<
+              "clients lost: " << lost_client_count << '\n' <<
+              "tps: " << (seconds > 0 ? latencies.Count() / seconds : 0) << '\n' <<
+              "latency average: " << latencies.Mean() / 1000 << " ms, min: " <<
+              toMilliseconds(latencies.Min()) << " ms, max: " <<
+              toMilliseconds(latencies.Max()) << " ms\n" <<
+              "latency p50: " << toMilliseconds(latencies.ValueAtPercentile(50)) <<
+              " ms, p95: " << toMilliseconds(latencies.ValueAtPercentile(95)) <<
+              " ms, p99: " << toMilliseconds(latencies.ValueAtPercentile(99)) <<
+              " ms, p99.9: " << toMilliseconds(latencies.ValueAtPercentile(99.9)) <<
+              " ms" << std::defaultfloat << std::endl;
+}
+
+}
+
+
+namespace psqlxx {
+
+void AddBenchOptions(cxxopts::Options &options) {
+    options.add_options("Bench")
+    ("bench",
+     "run the -c commands or -f file statements repeatedly as a benchmark, then report throughput and latency",
+     cxxopts::value<bool>()->default_value("false"))
+    ("clients", "number of client connections to benchmark with",
+     cxxopts::value<std::size_t>()->default_value("1"), "N")
+    ("threads", "number of threads to drive the clients",
+     cxxopts::value<std::size_t>()->default_value("1"), "N")
+    ("bench-time", "run the benchmark for SECONDS, 0 for no time limit",
+     cxxopts::value<std::size_t>()->default_value("0"), "SECONDS")
+    ("transactions",
+     "number of transactions each client runs, 0 for no limit; 10 if no --bench-time is given either",
+     cxxopts::value<std::size_t>()->default_value("0"), "N")
+    ;
+}
+
+BenchOptions HandleBenchOptions(const cxxopts::ParseResult &parsed_options) {
+    BenchOptions options{};
+
+    options.enabled = parsed_options["bench"].as<bool>();
+    options.clients = std::max<std::size_t>(parsed_options["clients"].as<std::size_t>(), 1);
+    options.threads = std::clamp<std::size_t>(parsed_options["threads"].as<std::size_t>(), 1,
+                                              options.clients);
+    options.seconds = parsed_options["bench-time"].as<std::size_t>();
+    options.transactions = parsed_options["transactions"].as<std::size_t>();
+    if (options.seconds == 0 and options.transactions == 0) {
+        options.transactions = 10;
+    }
+
+    return options;
+}
+
+bool RunBench(const DbProxy &proxy) {
+    const auto &proxy_options = proxy.GetOptions();
+    const auto &options = proxy_options.bench_options;
+
+    const auto statements = getBenchStatements(proxy_options);
+    if (statements.empty()) {
+        return false;
+    }
+
+    // Connections are set up before the clock starts.
+    std::vector<Client> clients(options.clients);
+    for (auto &a_client : clients) {
+        a_client.connection = connectClient(proxy.GetConnectionString(), statements);
+        if (not a_client.connection) {
+            return false;
+        }
+    }
+
+    std::vector<std::vector<Client *>> thread_clients(options.threads);
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        thread_clients[i % options.threads].push_back(&clients[i]);
+    }
+
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::seconds(options.seconds);
+    std::vector<ThreadReport> reports(options.threads);
+    std::vector<std::thread> threads;
+    threads.reserve(options.threads);
+    for (std::size_t i = 0; i < options.threads; ++i) {
+        threads.emplace_back([&options, &statements, deadline, &reports, &thread_clients, i] {
+            const ClientDriver driver{options, statements.size(), deadline, reports[i]};
+            driver.Run(thread_clients[i]);
+        });
+    }
+    for (auto &a_thread : threads) {
+        a_thread.join();
+    }
+    const auto elapsed = Clock::now() - start;
+
+    LatencyHistogram latencies;
+    std::size_t failed_count = 0;
+    std::size_t lost_client_count = 0;
+    for (const auto &a_report : reports) {
+        latencies.Merge(a_report.latencies);
+        failed_count += a_report.failed_count;
+        lost_client_count += a_report.lost_client_count;
+    }
+
+    printReport(options, statements.size(), latencies, failed_count, lost_client_count, elapsed);
+    return failed_count == 0 and lost_client_count == 0;
+}
+
+}//namespace psqlxx
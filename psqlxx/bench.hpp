@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace cxxopts {
+
+class Options;
+class ParseResult;
+
+}
+
+
+namespace psqlxx {
+
+class DbProxy;
+
+
+struct BenchOptions {
+    bool enabled = false;
+
+    std::size_t clients = 1;
+    std::size_t threads = 1;
+
+    // Run for this long, 0 for no time limit
+    std::size_t seconds = 0;
+    // Transactions of each client, 0 for no limit
+    std::size_t transactions = 0;
+};
+
+void AddBenchOptions(cxxopts::Options &options);
+
+[[nodiscard]]
+BenchOptions HandleBenchOptions(const cxxopts::ParseResult &parsed_options);
+
+
+/**
+ * Runs the -c commands or the -f file statements over and over as a benchmark, like pgbench.
+ * Each run of the statements is counted as one transaction. Clients send them as prepared
+ * statements on connections of their own, spread over threads which drive libpq
+ * asynchronously, then the throughput and latency percentiles are reported.
+ *
+ * @return  false if any transaction failed.
+ */
+[[nodiscard]]
+bool RunBench(const DbProxy &proxy);
+
+}//namespace psqlxx
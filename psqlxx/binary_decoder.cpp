@@ -0,0 +1,397 @@
+#include <psqlxx/binary_decoder.hpp>
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr std::int64_t USECS_PER_SEC = 1000000;
+constexpr std::int64_t USECS_PER_DAY = 86400 * USECS_PER_SEC;
+constexpr int POSTGRES_EPOCH_JDATE = 2451545;
+
+constexpr std::uint16_t NUMERIC_NEG = 0x4000;
+constexpr std::uint16_t NUMERIC_NAN = 0xC000;
+constexpr std::uint16_t NUMERIC_PINF = 0xD000;
+constexpr std::uint16_t NUMERIC_NINF = 0xF000;
+constexpr int NUMERIC_DEC_DIGITS = 4;
+
+
+template <typename Integer>
+[[nodiscard]]
+Integer readBigEndian(const std::string_view binary, const std::size_t offset = 0) {
+    std::make_unsigned_t<Integer> value = 0;
+    for (std::size_t i = 0; i < sizeof(Integer); ++i) {
+        value = (value << 8) | static_cast<unsigned char>(binary[offset + i]);
+    }
+    return static_cast<Integer>(value);
+}
+
+template <typename Integer>
+void appendInteger(std::string &text, const Integer value, const int min_digits = 1) {
+    std::array<char, std::numeric_limits<Integer>::digits10 + 2> digits{};
+    const auto *const end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    const auto length = static_cast<int>(end - digits.data());
+    if (length < min_digits) {
+        text.append(min_digits - length, '0');
+    }
+    text.append(digits.data(), length);
+}
+
+template <typename Integer>
+void decodeInteger(const std::string_view binary, std::string &text) {
+    if (binary.size() == sizeof(Integer)) {
+        appendInteger(text, readBigEndian<Integer>(binary));
+    }
+}
+
+void decodeBool(const std::string_view binary, std::string &text) {
+    if (binary.size() == 1) {
+        text.push_back(binary.front() ? 't' : 'f');
+    }
+}
+
+void decodeAsText(const std::string_view binary, std::string &text) {
+    text.append(binary);
+}
+
+void decodeChar(const std::string_view binary, std::string &text) {
+    if (binary.size() != 1 or binary.front() == '\0') {
+        return;
+    }
+
+    // The server prints the high bytes in octal, as they are not ASCII.
+    const auto byte = static_cast<unsigned char>(binary.front());
+    if (byte >= 0x80) {
+        text.push_back('\\');
+        text.push_back(static_cast<char>('0' + (byte >> 6)));
+        text.push_back(static_cast<char>('0' + ((byte >> 3) & 7)));
+        text.push_back(static_cast<char>('0' + (byte & 7)));
+    } else {
+        text.push_back(binary.front());
+    }
+}
+
+void decodeJsonb(const std::string_view binary, std::string &text) {
+    // The binary format is a version number, followed by the text.
+    if (not binary.empty()) {
+        text.append(binary.substr(1));
+    }
+}
+
+void decodeUuid(const std::string_view binary, std::string &text) {
+    constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+    if (binary.size() != 16) {
+        return;
+    }
+    for (std::size_t i = 0; i < binary.size(); ++i) {
+        if (i == 4 or i == 6 or i == 8 or i == 10) {
+            text.push_back('-');
+        }
+        const auto c = static_cast<unsigned char>(binary[i]);
+        text.push_back(HEX_DIGITS[c >> 4]);
+        text.push_back(HEX_DIGITS[c & 0x0F]);
+    }
+}
+
+/**
+ * Shortest round-trip digits, laid out the way the server's float output does:
+ * fixed-point if the decimal exponent is in [-4, max_fixed_exponent), otherwise exponential.
+ */
+template <typename Float>
+void appendFloat(std::string &text, const Float value, const int max_fixed_exponent) {
+    if (std::isnan(value)) {
+        text.append("NaN");
+        return;
+    }
+    if (std::isinf(value)) {
+        text.append(value < 0 ? "-Infinity" : "Infinity");
+        return;
+    }
+
+    std::array<char, 64> buffer{};
+    const auto *const end = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
+                                          std::chars_format::scientific).ptr;
+    const std::string_view scientific{buffer.data(), static_cast<std::size_t>(end - buffer.data())};
+
+    // scientific is "[-]d[.ddd]e(+|-)dd"
+    const auto e_position = scientific.find('e');
+    auto mantissa = scientific.substr(0, e_position);
+    int exponent = 0;
+    std::from_chars(scientific.data() + e_position + (scientific[e_position + 1] == '+' ? 2 : 1),
+                    scientific.data() + scientific.size(), exponent);
+
+    if (mantissa.front() == '-') {
+        text.push_back('-');
+        mantissa.remove_prefix(1);
+    }
+    std::string digits;
+    for (const auto c : mantissa) {
+        if (c != '.') {
+            digits.push_back(c);
+        }
+    }
+
+    if (exponent < -4 or exponent >= max_fixed_exponent) {
+        text.push_back(digits.front());
+        if (digits.size() > 1) {
+            text.push_back('.');
+            text.append(digits, 1);
+        }
+        text.push_back('e');
+        text.push_back(exponent < 0 ? '-' : '+');
+        appendInteger(text, std::abs(exponent), 2);
+    } else if (exponent < 0) {
+        text.append("0.");
+        text.append(-exponent - 1, '0');
+        text.append(digits);
+    } else {
+        const std::size_t integer_digits = exponent + 1;
+        if (digits.size() <= integer_digits) {
+            text.append(digits);
+            text.append(integer_digits - digits.size(), '0');
+        } else {
+            text.append(digits, 0, integer_digits);
+            text.push_back('.');
+            text.append(digits, integer_digits);
+        }
+    }
+}
+
+void decodeFloat4(const std::string_view binary, std::string &text) {
+    static_assert(sizeof(float) == sizeof(std::uint32_t));
+    if (binary.size() == sizeof(float)) {
+        const auto bits = readBigEndian<std::uint32_t>(binary);
+        float value{};
+        std::memcpy(&value, &bits, sizeof(value));
+        appendFloat(text, value, 6);
+    }
+}
+
+void decodeFloat8(const std::string_view binary, std::string &text) {
+    static_assert(sizeof(double) == sizeof(std::uint64_t));
+    if (binary.size() == sizeof(double)) {
+        const auto bits = readBigEndian<std::uint64_t>(binary);
+        double value{};
+        std::memcpy(&value, &bits, sizeof(value));
+        appendFloat(text, value, 15);
+    }
+}
+
+void decodeNumeric(const std::string_view binary, std::string &text) {
+    if (binary.size() < 8) {
+        return;
+    }
+
+    const auto ndigits = readBigEndian<std::int16_t>(binary, 0);
+    const auto weight = readBigEndian<std::int16_t>(binary, 2);
+    const auto sign = readBigEndian<std::uint16_t>(binary, 4);
+    const auto dscale = readBigEndian<std::int16_t>(binary, 6);
+    if (binary.size() != 8 + 2 * static_cast<std::size_t>(ndigits)) {
+        return;
+    }
+
+    switch (sign) {
+        case NUMERIC_NAN:
+            text.append("NaN");
+            return;
+        case NUMERIC_PINF:
+            text.append("Infinity");
+            return;
+        case NUMERIC_NINF:
+            text.append("-Infinity");
+            return;
+        default:
+            break;
+    }
+
+    const auto digit_at = [&binary, ndigits](const int i) -> int {
+        return (i >= 0 and i < ndigits) ? readBigEndian<std::int16_t>(binary, 8 + 2 * i) : 0;
+    };
+
+    if (sign == NUMERIC_NEG) {
+        text.push_back('-');
+    }
+
+    if (weight < 0) {
+        text.push_back('0');
+    } else {
+        appendInteger(text, digit_at(0));
+        for (int i = 1; i <= weight; ++i) {
+            appendInteger(text, digit_at(i), NUMERIC_DEC_DIGITS);
+        }
+    }
+
+    if (dscale > 0) {
+        text.push_back('.');
+        std::string fraction;
+        for (int i = weight + 1; static_cast<int>(fraction.size()) < dscale; ++i) {
+            appendInteger(fraction, digit_at(i), NUMERIC_DEC_DIGITS);
+        }
+        text.append(fraction, 0, dscale);
+    }
+}
+
+struct Date {
+    int year;
+    int month;
+    int day;
+};
+
+/**
+ * The same Julian day conversion the server uses.
+ */
+[[nodiscard]]
+Date julianToDate(const int julian_day) {
+    unsigned int julian = julian_day + 32044;
+    unsigned int quad = julian / 146097;
+    const unsigned int extra = (julian - quad * 146097) * 4 + 3;
+    julian += 60 + quad * 3 + extra / 146097;
+    quad = julian / 1461;
+    julian -= quad * 1461;
+    int y = julian * 4 / 1461;
+    julian = ((y != 0) ? ((julian + 305) % 365) : ((julian + 306) % 366)) + 123;
+    y += quad * 4;
+    quad = julian * 2141 / 65536;
+
+    return {y - 4800, static_cast<int>((quad + 10) % 12 + 1),
+            static_cast<int>(julian - 7834 * quad / 256)};
+}
+
+void appendDate(std::string &text, const Date &date) {
+    appendInteger(text, date.year > 0 ? date.year : 1 - date.year, 4);
+    text.push_back('-');
+    appendInteger(text, date.month, 2);
+    text.push_back('-');
+    appendInteger(text, date.day, 2);
+}
+
+void appendTime(std::string &text, std::int64_t time) {
+    const auto hours = time / (3600 * USECS_PER_SEC);
+    time -= hours * 3600 * USECS_PER_SEC;
+    const auto minutes = time / (60 * USECS_PER_SEC);
+    time -= minutes * 60 * USECS_PER_SEC;
+    const auto seconds = time / USECS_PER_SEC;
+    auto fraction = time - seconds * USECS_PER_SEC;
+
+    appendInteger(text, hours, 2);
+    text.push_back(':');
+    appendInteger(text, minutes, 2);
+    text.push_back(':');
+    appendInteger(text, seconds, 2);
+
+    if (fraction != 0) {
+        int digits = 6;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            --digits;
+        }
+        text.push_back('.');
+        appendInteger(text, fraction, digits);
+    }
+}
+
+void decodeDate(const std::string_view binary, std::string &text) {
+    if (binary.size() != sizeof(std::int32_t)) {
+        return;
+    }
+
+    const auto days = readBigEndian<std::int32_t>(binary);
+    if (days == std::numeric_limits<std::int32_t>::min()) {
+        text.append("-infinity");
+    } else if (days == std::numeric_limits<std::int32_t>::max()) {
+        text.append("infinity");
+    } else {
+        const auto date = julianToDate(days + POSTGRES_EPOCH_JDATE);
+        appendDate(text, date);
+        if (date.year <= 0) {
+            text.append(" BC");
+        }
+    }
+}
+
+void decodeTime(const std::string_view binary, std::string &text) {
+    if (binary.size() == sizeof(std::int64_t)) {
+        appendTime(text, readBigEndian<std::int64_t>(binary));
+    }
+}
+
+void decodeTimestamp(const std::string_view binary, std::string &text) {
+    if (binary.size() != sizeof(std::int64_t)) {
+        return;
+    }
+
+    const auto timestamp = readBigEndian<std::int64_t>(binary);
+    if (timestamp == std::numeric_limits<std::int64_t>::min()) {
+        text.append("-infinity");
+        return;
+    }
+    if (timestamp == std::numeric_limits<std::int64_t>::max()) {
+        text.append("infinity");
+        return;
+    }
+
+    auto days = timestamp / USECS_PER_DAY;
+    auto time = timestamp - days * USECS_PER_DAY;
+    if (time < 0) {
+        time += USECS_PER_DAY;
+        --days;
+    }
+
+    const auto date = julianToDate(static_cast<int>(days) + POSTGRES_EPOCH_JDATE);
+    appendDate(text, date);
+    text.push_back(' ');
+    appendTime(text, time);
+    if (date.year <= 0) {
+        text.append(" BC");
+    }
+}
+
+}
+
+
+namespace psqlxx {
+
+BinaryDecoder GetBinaryDecoder(const std::string_view type_name) {
+    static const std::unordered_map<std::string_view, BinaryDecoder> DECODERS {
+        {"bool", &decodeBool},
+        {"int2", &decodeInteger<std::int16_t>},
+        {"int4", &decodeInteger<std::int32_t>},
+        {"int8", &decodeInteger<std::int64_t>},
+        {"oid", &decodeInteger<std::uint32_t>},
+        {"xid", &decodeInteger<std::uint32_t>},
+        {"cid", &decodeInteger<std::uint32_t>},
+        {"float4", &decodeFloat4},
+        {"float8", &decodeFloat8},
+        {"numeric", &decodeNumeric},
+        {"text", &decodeAsText},
+        {"varchar", &decodeAsText},
+        {"bpchar", &decodeAsText},
+        {"name", &decodeAsText},
+        {"char", &decodeChar},
+        {"json", &decodeAsText},
+        {"jsonb", &decodeJsonb},
+        {"uuid", &decodeUuid},
+        {"date", &decodeDate},
+        {"time", &decodeTime},
+        {"timestamp", &decodeTimestamp},
+    };
+
+    const auto iter = DECODERS.find(type_name);
+    return iter == DECODERS.cend() ? nullptr : iter->second;
+}
+
+bool IsDateTimeType(const std::string_view type_name) {
+    return type_name == "date" or type_name == "time" or type_name == "timestamp";
+}
+
+}//namespace psqlxx
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+
+namespace psqlxx {
+
+/**
+ * Appends the text form of a value received in binary format.
+ */
+using BinaryDecoder = void (*)(const std::string_view binary, std::string &text);
+
+/**
+ * @return  A decoder which produces exactly what the server would send in text format,
+ *          or nullptr if the type is not supported.
+ *
+ * @note    Date and time types are decoded in the ISO DateStyle.
+ */
+[[nodiscard]]
+BinaryDecoder GetBinaryDecoder(const std::string_view type_name);
+
+[[nodiscard]]
+bool IsDateTimeType(const std::string_view type_name);
+
+}//namespace psqlxx
@@ -0,0 +1,119 @@
+#include <psqlxx/binary_decoder.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace std::string_literals;
+
+
+namespace {
+
+[[nodiscard]]
+auto decode(const std::string_view type_name, const std::string &binary) {
+    const auto decoder = GetBinaryDecoder(type_name);
+    EXPECT_NE(nullptr, decoder);
+
+    std::string text;
+    if (decoder) {
+        decoder(binary, text);
+    }
+    return text;
+}
+
+[[nodiscard]]
+auto toBigEndian(std::uint64_t value, const std::size_t size) {
+    std::string binary(size, '\0');
+    for (auto iter = binary.rbegin(); iter != binary.rend(); ++iter) {
+        *iter = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    return binary;
+}
+
+[[nodiscard]]
+auto toNumeric(const std::int16_t weight, const std::uint16_t sign, const std::int16_t dscale,
+               const std::vector<std::uint16_t> &digits) {
+    auto binary = toBigEndian(digits.size(), 2) + toBigEndian(weight & 0xFFFF, 2) +
+                  toBigEndian(sign, 2) + toBigEndian(dscale, 2);
+    for (const auto digit : digits) {
+        binary += toBigEndian(digit, 2);
+    }
+    return binary;
+}
+
+}
+
+
+TEST(GetBinaryDecoderTests, ReturnNullIfGivenUnsupportedType) {
+    ASSERT_EQ(nullptr, GetBinaryDecoder("timestamptz"));
+    ASSERT_EQ(nullptr, GetBinaryDecoder("interval"));
+    ASSERT_EQ(nullptr, GetBinaryDecoder(""));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeBool) {
+    ASSERT_EQ("t", decode("bool", "\1"s));
+    ASSERT_EQ("f", decode("bool", "\0"s));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeCharAsTheServerPrintsIt) {
+    ASSERT_EQ("a", decode("char", "a"s));
+    ASSERT_EQ("", decode("char", "\0"s));
+    ASSERT_EQ("\\351", decode("char", "\xE9"s));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeIntegers) {
+    ASSERT_EQ("-2", decode("int2", toBigEndian(0xFFFE, 2)));
+    ASSERT_EQ("2147483647", decode("int4", toBigEndian(0x7FFFFFFF, 4)));
+    ASSERT_EQ("-9223372036854775808", decode("int8", toBigEndian(0x8000000000000000, 8)));
+    ASSERT_EQ("4294967295", decode("oid", toBigEndian(0xFFFFFFFF, 4)));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeFloatsAsTheServerPrintsThem) {
+    ASSERT_EQ("1.5", decode("float8", toBigEndian(0x3FF8000000000000, 8)));
+    ASSERT_EQ("100", decode("float8", toBigEndian(0x4059000000000000, 8)));
+    ASSERT_EQ("0.1", decode("float8", toBigEndian(0x3FB999999999999A, 8)));
+    ASSERT_EQ("0.0001", decode("float8", toBigEndian(0x3F1A36E2EB1C432D, 8)));
+    ASSERT_EQ("1e-05", decode("float8", toBigEndian(0x3EE4F8B588E368F1, 8)));
+    ASSERT_EQ("1e+15", decode("float8", toBigEndian(0x430C6BF526340000, 8)));
+    ASSERT_EQ("-0", decode("float8", toBigEndian(0x8000000000000000, 8)));
+    ASSERT_EQ("Infinity", decode("float8", toBigEndian(0x7FF0000000000000, 8)));
+    ASSERT_EQ("-Infinity", decode("float8", toBigEndian(0xFFF0000000000000, 8)));
+    ASSERT_EQ("NaN", decode("float8", toBigEndian(0x7FF8000000000000, 8)));
+
+    ASSERT_EQ("100000", decode("float4", toBigEndian(0x47C35000, 4)));
+    ASSERT_EQ("1e+06", decode("float4", toBigEndian(0x49742400, 4)));
+    ASSERT_EQ("0.1", decode("float4", toBigEndian(0x3DCCCCCD, 4)));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeNumeric) {
+    ASSERT_EQ("0", decode("numeric", toNumeric(0, 0, 0, {})));
+    ASSERT_EQ("0.00", decode("numeric", toNumeric(0, 0, 2, {})));
+    ASSERT_EQ("12345678.9", decode("numeric", toNumeric(1, 0, 1, {1234, 5678, 9000})));
+    ASSERT_EQ("-0.0012", decode("numeric", toNumeric(-1, 0x4000, 4, {12})));
+    ASSERT_EQ("10000", decode("numeric", toNumeric(1, 0, 0, {1})));
+    ASSERT_EQ("NaN", decode("numeric", toNumeric(0, 0xC000, 0, {})));
+    ASSERT_EQ("-Infinity", decode("numeric", toNumeric(0, 0xF000, 0, {})));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeDatesAndTimes) {
+    ASSERT_EQ("2000-01-01", decode("date", toBigEndian(0, 4)));
+    ASSERT_EQ("2024-02-29", decode("date", toBigEndian(8825, 4)));
+    ASSERT_EQ("1999-12-31", decode("date", toBigEndian(0xFFFFFFFF, 4)));
+    ASSERT_EQ("0001-12-31 BC", decode("date", toBigEndian(-730120 & 0xFFFFFFFF, 4)));
+    ASSERT_EQ("infinity", decode("date", toBigEndian(0x7FFFFFFF, 4)));
+
+    ASSERT_EQ("12:34:56", decode("time", toBigEndian(45296000000, 8)));
+    ASSERT_EQ("00:00:00.5", decode("time", toBigEndian(500000, 8)));
+
+    ASSERT_EQ("2000-01-01 00:00:01.000123", decode("timestamp", toBigEndian(1000123, 8)));
+    ASSERT_EQ("1999-12-31 23:59:59", decode("timestamp", toBigEndian(-1000000, 8)));
+    ASSERT_EQ("-infinity", decode("timestamp", toBigEndian(0x8000000000000000, 8)));
+}
+
+TEST(GetBinaryDecoderTests, CanDecodeTextLikeTypes) {
+    ASSERT_EQ("a\0b"s, decode("text", "a\0b"s));
+    ASSERT_EQ(R"({"a": 1})", decode("jsonb", "\1{\"a\": 1}"s));
+    ASSERT_EQ("00112233-4455-6677-8899-aabbccddeeff",
+              decode("uuid", toBigEndian(0x0011223344556677, 8) + toBigEndian(0x8899AABBCCDDEEFF, 8)));
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+
+namespace psqlxx {
+
+/**
+ * A blocking queue of limited capacity, to hand work from one pipeline stage to the next.
+ *
+ * @note    Intended for a single producer and a single consumer.
+ */
+template <typename T>
+class BoundedQueue {
+    const std::size_t m_capacity;
+
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    std::deque<T> m_items;
+    bool m_closed = false;
+
+public:
+    explicit BoundedQueue(const std::size_t capacity): m_capacity(capacity ? capacity : 1) {
+    }
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * Blocks while the queue is full.
+     *
+     * @return  false if the queue has been closed, in which case item is dropped.
+     */
+    bool Push(T item) {
+        std::unique_lock lock{m_mutex};
+        m_not_full.wait(lock, [this] {
+            return m_closed or m_items.size() < m_capacity;
+        });
+        if (m_closed) {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * Blocks while the queue is empty and open.
+     *
+     * @return  nullopt once the queue is closed and drained.
+     */
+    [[nodiscard]]
+    std::optional<T> Pop() {
+        std::unique_lock lock{m_mutex};
+        m_not_empty.wait(lock, [this] {
+            return m_closed or not m_items.empty();
+        });
+        if (m_items.empty()) {
+            return std::nullopt;
+        }
+
+        std::optional<T> item{std::move(m_items.front())};
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return item;
+    }
+
+    /**
+     * No more items can be pushed after this, but the ones queued can still be popped.
+     */
+    void Close() {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+};
+
+}//namespace psqlxx
@@ -0,0 +1,58 @@
+#include <psqlxx/bounded_queue.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(BoundedQueueTests, PopReturnsItemsInOrder) {
+    BoundedQueue<int> queue{4};
+    ASSERT_TRUE(queue.Push(1));
+    ASSERT_TRUE(queue.Push(2));
+
+    ASSERT_EQ(1, queue.Pop());
+    ASSERT_EQ(2, queue.Pop());
+}
+
+TEST(BoundedQueueTests, PopReturnsNulloptAfterCloseAndDrain) {
+    BoundedQueue<int> queue{4};
+    ASSERT_TRUE(queue.Push(1));
+    queue.Close();
+
+    ASSERT_EQ(1, queue.Pop());
+    ASSERT_FALSE(queue.Pop());
+}
+
+TEST(BoundedQueueTests, PushFailsAfterClose) {
+    BoundedQueue<int> queue{4};
+    queue.Close();
+
+    ASSERT_FALSE(queue.Push(1));
+}
+
+TEST(BoundedQueueTests, ProducerAndConsumerOnDifferentThreads) {
+    constexpr int COUNT = 10000;
+    BoundedQueue<int> queue{2};
+
+    std::thread producer{[&queue] {
+        for (int i = 0; i < COUNT; ++i) {
+            queue.Push(i);
+        }
+        queue.Close();
+    }};
+
+    std::vector<int> popped;
+    while (const auto item = queue.Pop()) {
+        popped.push_back(*item);
+    }
+    producer.join();
+
+    ASSERT_EQ(static_cast<std::size_t>(COUNT), popped.size());
+    for (int i = 0; i < COUNT; ++i) {
+        ASSERT_EQ(i, popped[i]);
+    }
+}
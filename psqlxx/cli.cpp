@@ -117,7 +117,12 @@ CliOptions::CliOptions(std::string prog,
 }
 
 
-void Cli::handleSignal() const {
+void Cli::handleSignal(const int sig) const {
+    // While a statement runs, 'Ctrl+c' cancels it, and the session goes on.
+    if (sig == SIGINT and m_proxy.CancelStatement()) {
+        return;
+    }
+
     el_reset(m_el);
     tok_reset(m_tokenizer);
 
@@ -130,6 +135,7 @@ Press <Enter> to continue: )" << std::flush;
 
 Cli::Cli(CliOptions options, const DbProxy &proxy):
     m_options(std::move(options)),
+    m_proxy(proxy),
     m_history(history_init()),
     m_ev(new HistEvent()),
     m_tokenizer(tok_init(nullptr)) {
@@ -140,7 +146,18 @@ Cli::Cli(CliOptions options, const DbProxy &proxy):
 
     g_prompt_handler = [&proxy](auto *) {
         static std::string buffer;
-        buffer = proxy.GetDbName() + "=# ";
+        buffer = proxy.GetDbName() + "=";
+        switch (proxy.GetTransactionStatus()) {
+            case TransactionStatus::in_transaction:
+                buffer += '*';
+                break;
+            case TransactionStatus::failed:
+                buffer += '!';
+                break;
+            default:
+                break;
+        }
+        buffer += "# ";
         return buffer.c_str();
     };
 }
@@ -159,8 +176,8 @@ Cli::~Cli() {
 }
 
 void Cli::Config() const {
-    g_signal_handler = [this](auto) {
-        handleSignal();
+    g_signal_handler = [this](const auto sig) {
+        handleSignal(sig);
     };
     (void) std::signal(SIGINT, signalHandler);  // Handle 'Ctrl+c'
     (void) std::signal(SIGQUIT, signalHandler); // Handle 'Ctrl+\'
@@ -231,6 +248,12 @@ int Cli::complete(EditLine *const el, const int /*ch*/) const {
     }
 }
 
+const char *Cli::readLine(int &line_length) const {
+    // The connection is kept alive while waiting for the user.
+    const auto idle = m_proxy.KeepAliveWhileIdle();
+    return el_gets(m_el, &line_length);
+}
+
 void Cli::greet() const {
     std::cout << m_options.prog_name << " (" << GetVersion() << ")\n";
     std::cout << "Type \"help\" for help.\n" << std::endl;
@@ -244,7 +267,7 @@ bool Cli::Run() const {
     bool previous_line_completed = true;
     bool last_result = true;
 
-    while ((a_line = el_gets(m_el, &line_length)) and line_length != 0)  {
+    while ((a_line = readLine(line_length)) and line_length != 0)  {
         if (m_signal_received.load()) {
             previous_line_completed = true;
             m_signal_received = false;
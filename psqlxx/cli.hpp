@@ -46,6 +46,8 @@ struct CliOptions {
 class Cli {
     const CliOptions m_options;
 
+    const DbProxy &m_proxy;
+
     std::vector<CommandGroup> m_command_groups;
 
     mutable std::atomic<bool> m_signal_received{false};
@@ -59,7 +61,9 @@ class Cli {
 
     [[nodiscard]]
     int complete(EditLine *const el, const int ch) const;
-    void handleSignal() const;
+    void handleSignal(const int sig) const;
+    [[nodiscard]]
+    const char *readLine(int &line_length) const;
     void greet() const;
 
 public:
@@ -8,6 +8,7 @@
 
 #include <psqlxx/exception.hpp>
 #include <psqlxx/string_utils.hpp>
+#include <psqlxx/trace.hpp>
 
 
 using namespace std::string_literals;
@@ -22,7 +23,7 @@ inline auto validName(const Command::NameType &name) {
         return true;
     }
 
-    static const std::regex name_pattern(R"(@?[a-zA-Z]+)");
+    static const std::regex name_pattern(R"(@?[a-zA-Z]+(-[a-zA-Z]+)*)");
     return std::regex_match(name.data(), name_pattern);
 }
 
@@ -167,6 +168,8 @@ CommandResult CommandGroup::operator()(const char **words, const int word_count)
     assert(words);
     assert(word_count > 0);
 
+    const TraceSpan span{"CommandGroup::operator()"};
+
     const auto iter = m_name_command_map.find(words[0]);
     if (iter != m_name_command_map.cend()) {
         return (*(iter->second))(words, word_count);
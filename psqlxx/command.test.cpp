@@ -54,6 +54,16 @@ TEST(ValidCommandTests, ReturnFalseIfArgumentStartsWithCommandPrefix) {
     ASSERT_FALSE(internal::validCommand({}, {"@ARGS"}, &Quit));
 }
 
+TEST(ValidCommandTests, ReturnTrueIfNameHasInnerHyphens) {
+    ASSERT_TRUE(internal::validCommand({"@dump-table"}, {}, &Quit));
+}
+
+TEST(ValidCommandTests, ReturnFalseIfNameStartsOrEndsWithHyphen) {
+    ASSERT_FALSE(internal::validCommand({"-quit"}, {}, &Quit));
+    ASSERT_FALSE(internal::validCommand({"@-quit"}, {}, &Quit));
+    ASSERT_FALSE(internal::validCommand({"quit-"}, {}, &Quit));
+}
+
 TEST(ValidCommandTests, ForNameCommandPrefixIsNotAllowedOtherThanStart) {
     ASSERT_FALSE(internal::validCommand({"quit@"}, {}, &Quit));
 }
@@ -0,0 +1,296 @@
+#include <psqlxx/connect_race.hpp>
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include <psqlxx/pq.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Parameters = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @return  The parameters set in connection_string, nullopt if it is invalid.
+ */
+[[nodiscard]]
+std::optional<Parameters> parseParameters(const std::string &connection_string) {
+    char *error = nullptr;
+    const pq::ConninfoPtr options{PQconninfoParse(connection_string.c_str(), &error)};
+    if (not options) {
+        PQfreemem(error);
+        return std::nullopt;
+    }
+
+    Parameters parameters;
+    for (auto *an_option = options.get(); an_option->keyword; ++an_option) {
+        if (an_option->val) {
+            parameters.emplace_back(an_option->keyword, an_option->val);
+        }
+    }
+    return parameters;
+}
+
+[[nodiscard]]
+std::vector<std::string> splitList(const std::string_view list) {
+    std::vector<std::string> items;
+    if (list.empty()) {
+        return items;
+    }
+
+    std::size_t begin = 0;
+    for (auto end = list.find(','); end != std::string_view::npos; end = list.find(',', begin)) {
+        items.emplace_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    items.emplace_back(list.substr(begin));
+    return items;
+}
+
+/**
+ * @return  The i-th of count items, which may also be given as a single item for all.
+ */
+[[nodiscard]]
+inline const std::string &pickItem(const std::vector<std::string> &items, const std::size_t i) {
+    return items.size() == 1 ? items.front() : items[i];
+}
+
+[[nodiscard]]
+std::string composeConnectionString(const Parameters &parameters) {
+    std::string connection_string;
+    for (const auto &[keyword, value] : parameters) {
+        if (not connection_string.empty()) {
+            connection_string += ' ';
+        }
+        connection_string += keyword;
+        connection_string += "='";
+        for (const auto c : value) {
+            if (c == '\'' or c == '\\') {
+                connection_string += '\\';
+            }
+            connection_string += c;
+        }
+        connection_string += '\'';
+    }
+    return connection_string;
+}
+
+/**
+ * @return  The connect_timeout of connection_string, which libpq raises to 2 seconds if less,
+ *          or zero for none.
+ */
+[[nodiscard]]
+Clock::duration getConnectTimeout(const std::string &connection_string) {
+    const auto parameters = parseParameters(connection_string);
+    if (parameters) {
+        for (const auto &[keyword, value] : *parameters) {
+            if (keyword == "connect_timeout") {
+                const auto seconds = std::atoi(value.c_str());
+                if (seconds > 0) {
+                    return std::chrono::seconds{std::max(seconds, 2)};
+                }
+            }
+        }
+    }
+    return Clock::duration::zero();
+}
+
+/**
+ * @return  The host, or else hostaddr, and port of host_connection_string, for messages.
+ */
+[[nodiscard]]
+std::string describeHost(const std::string &host_connection_string) {
+    std::string host;
+    std::string port;
+    const auto parameters = parseParameters(host_connection_string).value_or(Parameters{});
+    for (const auto &[keyword, value] : parameters) {
+        if (keyword == "host" or (keyword == "hostaddr" and host.empty())) {
+            host = value;
+        } else if (keyword == "port") {
+            port = value;
+        }
+    }
+    return "connection to server at \"" + host + "\"" + (port.empty() ? "" : ", port " + port);
+}
+
+struct Attempt {
+    std::unique_ptr<pqxx::connecting> connecting;
+    Clock::time_point deadline;
+    bool has_deadline = false;
+};
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::vector<std::string> splitHosts(const std::string &connection_string) {
+    const auto parameters = parseParameters(connection_string);
+    if (not parameters) {
+        return {};
+    }
+
+    std::vector<std::string> hosts;
+    std::vector<std::string> host_addresses;
+    std::vector<std::string> ports;
+    Parameters common_parameters;
+    for (const auto &[keyword, value] : *parameters) {
+        if (keyword == "host") {
+            hosts = splitList(value);
+        } else if (keyword == "hostaddr") {
+            host_addresses = splitList(value);
+        } else if (keyword == "port") {
+            ports = splitList(value);
+        } else {
+            common_parameters.emplace_back(keyword, value);
+        }
+    }
+
+    const auto host_count = std::max(hosts.size(), host_addresses.size());
+    const auto pairs_up = [host_count](const std::vector<std::string> &items) {
+        return items.size() <= 1 or items.size() == host_count;
+    };
+    if (host_count < 2 or (not hosts.empty() and hosts.size() != host_count) or
+        (not host_addresses.empty() and host_addresses.size() != host_count) or
+        not pairs_up(ports)) {
+        return {};
+    }
+
+    std::vector<std::string> host_connection_strings;
+    for (std::size_t i = 0; i < host_count; ++i) {
+        auto host_parameters = common_parameters;
+        // An empty item, like the port of db1 in postgresql://db1,db2:6432, is the default.
+        const auto add_item = [&host_parameters, i](const std::string & keyword,
+                                                    const std::vector<std::string> &items) {
+            if (not items.empty() and not pickItem(items, i).empty()) {
+                host_parameters.emplace_back(keyword, pickItem(items, i));
+            }
+        };
+        add_item("host", hosts);
+        add_item("hostaddr", host_addresses);
+        add_item("port", ports);
+        host_connection_strings.push_back(composeConnectionString(host_parameters));
+    }
+
+    return host_connection_strings;
+}
+
+}//namespace internal
+
+
+pqxx::connection ConnectToFastestHost(const std::string &connection_string,
+                                      const std::chrono::milliseconds stagger) {
+    const auto host_connection_strings = internal::splitHosts(connection_string);
+    if (host_connection_strings.empty()) {
+        return pqxx::connection{connection_string};
+    }
+
+    const auto connect_timeout = getConnectTimeout(connection_string);
+    std::vector<Attempt> attempts;
+    attempts.reserve(host_connection_strings.size());
+    auto next_start = Clock::now();
+    std::string error_message;
+
+    const auto fail = [&error_message](Attempt & an_attempt, const std::string_view error) {
+        error_message += error;
+        an_attempt.connecting.reset();
+    };
+
+    while (true) {
+        auto now = Clock::now();
+        const auto in_progress = std::count_if(attempts.cbegin(), attempts.cend(),
+        [](const auto & an_attempt) {
+            return static_cast<bool>(an_attempt.connecting);
+        });
+
+        if (attempts.size() < host_connection_strings.size() and
+            (now >= next_start or in_progress == 0)) {
+            auto &an_attempt = attempts.emplace_back();
+            if (connect_timeout > connect_timeout.zero()) {
+                an_attempt.deadline = now + connect_timeout;
+                an_attempt.has_deadline = true;
+            }
+            try {
+                an_attempt.connecting = std::make_unique<pqxx::connecting>(
+                                            host_connection_strings[attempts.size() - 1]);
+            } catch (const pqxx::broken_connection &e) {
+                fail(an_attempt, e.what());
+            }
+            next_start = now + stagger;
+            continue;
+        }
+
+        if (in_progress == 0) {
+            throw pqxx::broken_connection{error_message};
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<Attempt *> polled_attempts;
+        auto wake_up = next_start;
+        auto has_wake_up = attempts.size() < host_connection_strings.size();
+        for (auto &an_attempt : attempts) {
+            if (an_attempt.connecting) {
+                // libpq may switch sockets, when it tries the next address of a host.
+                fds.push_back({an_attempt.connecting->sock(),
+                               static_cast<short>(an_attempt.connecting->wait_to_read() ?
+                                                  POLLIN : POLLOUT), 0});
+                polled_attempts.push_back(&an_attempt);
+                if (an_attempt.has_deadline) {
+                    wake_up = has_wake_up ? std::min(wake_up, an_attempt.deadline) :
+                              an_attempt.deadline;
+                    has_wake_up = true;
+                }
+            }
+        }
+
+        auto timeout_ms = -1;
+        if (has_wake_up) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wake_up - now);
+            timeout_ms = std::max<std::chrono::milliseconds::rep>(remaining.count(), 0);
+        }
+        if (poll(fds.data(), fds.size(), timeout_ms) < 0 and errno != EINTR) {
+            throw pqxx::broken_connection{error_message + "failed to wait for the servers: " +
+                                          std::strerror(errno)};
+        }
+
+        now = Clock::now();
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            auto &an_attempt = *polled_attempts[i];
+            const auto &host_connection_string =
+                host_connection_strings[&an_attempt - attempts.data()];
+            if (fds[i].revents == 0) {
+                if (an_attempt.has_deadline and now >= an_attempt.deadline) {
+                    fail(an_attempt, describeHost(host_connection_string) +
+                         " failed: timeout expired\n");
+                }
+                continue;
+            }
+
+            try {
+                an_attempt.connecting->process();
+            } catch (const pqxx::broken_connection &e) {
+                fail(an_attempt, e.what());
+                continue;
+            }
+            if (an_attempt.connecting->done()) {
+                // The other attempts are abandoned, as they are destroyed.
+                return std::move(*an_attempt.connecting).produce();
+            }
+        }
+    }
+}
+
+}//namespace psqlxx
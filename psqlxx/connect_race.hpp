@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <pqxx/pqxx>
+
+
+namespace psqlxx {
+
+/**
+ * Connects to every host of a multi-host connection_string at once, rather than one after
+ * another as libpq does, so that an unreachable host does not delay the others by its
+ * connect_timeout. Each attempt starts stagger after the previous one, or as soon as all
+ * attempts in progress have failed, and the first connection which succeeds and meets
+ * target_session_attrs wins. The others are abandoned.
+ *
+ * @note    Host names are resolved when their attempt starts, which blocks.
+ *
+ * @return  The winning connection, or a plain connection if connection_string names one
+ *          host only.
+ * @throws  pqxx::broken_connection with the errors of all attempts, if they all failed.
+ */
+[[nodiscard]]
+pqxx::connection ConnectToFastestHost(const std::string &connection_string,
+                                      const std::chrono::milliseconds stagger =
+                                          std::chrono::milliseconds{250});
+
+namespace internal {
+
+/**
+ * Splits the host, hostaddr and port lists of connection_string, in keyword/value or URI form.
+ *
+ * @return  A keyword/value connection string per host, with its own host, hostaddr and port,
+ *          and the other parameters of connection_string. Empty if there are less than two
+ *          hosts, or if the lists cannot be paired up, which libpq reports when connecting.
+ */
+[[nodiscard]]
+std::vector<std::string> splitHosts(const std::string &connection_string);
+
+}//namespace internal
+
+}//namespace psqlxx
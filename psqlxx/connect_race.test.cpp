@@ -0,0 +1,60 @@
+#include <psqlxx/connect_race.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(SplitHostsTests, ReturnEmptyIfGivenOneHost) {
+    ASSERT_TRUE(internal::splitHosts("host=db1 port=5432 dbname=app").empty());
+    ASSERT_TRUE(internal::splitHosts("").empty());
+}
+
+TEST(SplitHostsTests, CanSplitHostsAndPorts) {
+    const auto host_strings =
+        internal::splitHosts("host=db1,db2 port=5432,5433 dbname=app target_session_attrs=read-write");
+
+    ASSERT_EQ((std::vector<std::string> {
+        "dbname='app' target_session_attrs='read-write' host='db1' port='5432'",
+        "dbname='app' target_session_attrs='read-write' host='db2' port='5433'"}),
+    host_strings);
+}
+
+TEST(SplitHostsTests, CanShareSinglePort) {
+    const auto host_strings = internal::splitHosts("host=db1,db2 port=6432");
+
+    ASSERT_EQ((std::vector<std::string> {"host='db1' port='6432'", "host='db2' port='6432'"}),
+              host_strings);
+}
+
+TEST(SplitHostsTests, CanSplitUri) {
+    const auto host_strings = internal::splitHosts("postgresql://db1,db2:6432/app");
+
+    ASSERT_EQ((std::vector<std::string> {"dbname='app' host='db1'",
+                                         "dbname='app' host='db2' port='6432'"}),
+              host_strings);
+}
+
+TEST(SplitHostsTests, CanEscapeValues) {
+    const auto host_strings = internal::splitHosts(R"(host=a,b password='it\'s \\')");
+
+    ASSERT_EQ(2u, host_strings.size());
+    ASSERT_EQ(R"(password='it\'s \\' host='a')", host_strings[0]);
+}
+
+TEST(SplitHostsTests, ReturnEmptyIfListsDoNotPairUp) {
+    ASSERT_TRUE(internal::splitHosts("host=db1,db2,db3 port=5432,5433").empty());
+    ASSERT_TRUE(internal::splitHosts("host=db1,db2 hostaddr=10.0.0.1").empty());
+}
+
+TEST(ConnectToFastestHostTests, CanReportAllFailedHosts) {
+    // Nothing listens on port 1, so that both attempts are refused at once.
+    try {
+        static_cast<void>(ConnectToFastestHost("hostaddr=127.0.0.1,127.0.0.1 port=1"));
+        FAIL();
+    } catch (const pqxx::broken_connection &e) {
+        const std::string error_message = e.what();
+        ASSERT_NE(error_message.find("127.0.0.1"), error_message.rfind("127.0.0.1"));
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * Keeps idle connections for reuse, and makes new ones when none is idle.
+ *
+ * @note    Thread-safe. The pool must outlive its leases.
+ */
+template <typename Connection>
+class ConnectionPool {
+public:
+    using ConnectionPtr = std::unique_ptr<Connection>;
+    // Returns null after printing the error, if failed to connect
+    using Factory = std::function<ConnectionPtr()>;
+    using ReusablePredicate = std::function<bool(const Connection &)>;
+
+    /**
+     * Returns its connection to the pool on destruction.
+     */
+    class Lease {
+        ConnectionPool *m_pool;
+        ConnectionPtr m_connection;
+
+    public:
+        Lease(ConnectionPool &pool, ConnectionPtr a_connection):
+            m_pool(&pool), m_connection(std::move(a_connection)) {
+        }
+        Lease(Lease &&) = default;
+        Lease &operator=(Lease &&) = delete;
+
+        ~Lease() {
+            if (m_connection) {
+                m_pool->release(std::move(m_connection));
+            }
+        }
+
+        [[nodiscard]]
+        operator bool() const {
+            return static_cast<bool>(m_connection);
+        }
+
+        [[nodiscard]]
+        Connection &operator*() const {
+            return *m_connection;
+        }
+    };
+
+private:
+    const Factory m_factory;
+    const ReusablePredicate m_reusable;
+    const std::size_t m_max_idle_count;
+
+    std::mutex m_mutex;
+    std::vector<ConnectionPtr> m_idle_connections;
+
+    void release(ConnectionPtr a_connection) {
+        if (m_reusable and not m_reusable(*a_connection)) {
+            return;
+        }
+
+        const std::lock_guard lock{m_mutex};
+        if (m_idle_connections.size() < m_max_idle_count) {
+            m_idle_connections.push_back(std::move(a_connection));
+        }
+    }
+
+public:
+    explicit ConnectionPool(Factory factory, ReusablePredicate reusable = {},
+                            const std::size_t max_idle_count = 4):
+        m_factory(std::move(factory)),
+        m_reusable(std::move(reusable)),
+        m_max_idle_count(max_idle_count) {
+    }
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    /**
+     * @return  A lease which is false, if failed to connect.
+     */
+    [[nodiscard]]
+    Lease Acquire() {
+        {
+            const std::lock_guard lock{m_mutex};
+            if (not m_idle_connections.empty()) {
+                auto a_connection = std::move(m_idle_connections.back());
+                m_idle_connections.pop_back();
+                return {*this, std::move(a_connection)};
+            }
+        }
+
+        // Connecting takes a while, so it is done without holding the lock.
+        return {*this, m_factory()};
+    }
+
+    [[nodiscard]]
+    std::size_t IdleCount() {
+        const std::lock_guard lock{m_mutex};
+        return m_idle_connections.size();
+    }
+};
+
+}//namespace psqlxx
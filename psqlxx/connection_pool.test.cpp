@@ -0,0 +1,78 @@
+#include <psqlxx/connection_pool.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+struct FakeConnection {
+    int id = 0;
+    bool open = true;
+};
+
+[[nodiscard]]
+auto makeFactory(int &connect_count) {
+    return [&connect_count] {
+        return std::make_unique<FakeConnection>(FakeConnection{++connect_count});
+    };
+}
+
+}
+
+
+TEST(ConnectionPoolTests, CanReuseReleasedConnections) {
+    int connect_count = 0;
+    ConnectionPool<FakeConnection> pool{makeFactory(connect_count)};
+
+    {
+        const auto first_lease = pool.Acquire();
+        const auto second_lease = pool.Acquire();
+        ASSERT_TRUE(first_lease);
+        ASSERT_EQ(1, (*first_lease).id);
+        ASSERT_EQ(2, (*second_lease).id);
+    }
+    ASSERT_EQ(2u, pool.IdleCount());
+
+    {
+        const auto a_lease = pool.Acquire();
+        ASSERT_EQ(2, connect_count);
+        ASSERT_EQ(1u, pool.IdleCount());
+    }
+    ASSERT_EQ(2u, pool.IdleCount());
+}
+
+TEST(ConnectionPoolTests, CanDropUnusableConnections) {
+    int connect_count = 0;
+    ConnectionPool<FakeConnection> pool{makeFactory(connect_count),
+        [](const auto & a_connection) {
+            return a_connection.open;
+        }};
+
+    {
+        const auto a_lease = pool.Acquire();
+        (*a_lease).open = false;
+    }
+    ASSERT_EQ(0u, pool.IdleCount());
+}
+
+TEST(ConnectionPoolTests, CanLimitIdleConnections) {
+    int connect_count = 0;
+    ConnectionPool<FakeConnection> pool{makeFactory(connect_count), {}, 1};
+
+    {
+        const auto first_lease = pool.Acquire();
+        const auto second_lease = pool.Acquire();
+    }
+    ASSERT_EQ(1u, pool.IdleCount());
+}
+
+TEST(ConnectionPoolTests, ReturnFalseLeaseIfFailedToConnect) {
+    ConnectionPool<FakeConnection> pool{[] {
+        return std::unique_ptr<FakeConnection> {};
+    }};
+
+    ASSERT_FALSE(pool.Acquire());
+}
@@ -0,0 +1,150 @@
+#include <psqlxx/csv.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
+#include <psqlxx/output_buffer.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr char QUOTE = '"';
+
+[[nodiscard]]
+inline bool isCsvSpecialChar(const char c, const char delimiter) {
+    return c == delimiter or c == QUOTE or c == '\r' or c == '\n';
+}
+
+#if defined(__AVX2__)
+
+constexpr std::size_t BLOCK_SIZE = 32;
+
+[[nodiscard]]
+inline int matchBlock(const char *const data, const char delimiter) {
+    const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    const auto matches = _mm256_or_si256(
+                             _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(delimiter)),
+                                             _mm256_cmpeq_epi8(block, _mm256_set1_epi8(QUOTE))),
+                             _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')),
+                                             _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+    return _mm256_movemask_epi8(matches);
+}
+
+#elif defined(__SSE2__)
+
+constexpr std::size_t BLOCK_SIZE = 16;
+
+[[nodiscard]]
+inline int matchBlock(const char *const data, const char delimiter) {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const auto matches = _mm_or_si128(
+                             _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(delimiter)),
+                                          _mm_cmpeq_epi8(block, _mm_set1_epi8(QUOTE))),
+                             _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')),
+                                          _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+    return _mm_movemask_epi8(matches);
+}
+
+#endif
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::size_t findCsvSpecialCharScalar(const std::string_view a_field,
+                                     const char delimiter) {
+    for (std::size_t i = 0; i < a_field.size(); ++i) {
+        if (isCsvSpecialChar(a_field[i], delimiter)) {
+            return i;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+std::size_t findCsvSpecialChar(const std::string_view a_field, const char delimiter) {
+    std::size_t offset = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; offset + BLOCK_SIZE <= a_field.size(); offset += BLOCK_SIZE) {
+        const auto mask = matchBlock(a_field.data() + offset, delimiter);
+        if (mask != 0) {
+            return offset + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+
+    const auto position = findCsvSpecialCharScalar(a_field.substr(offset), delimiter);
+    return position == std::string_view::npos ? position : offset + position;
+}
+
+}//namespace internal
+
+
+bool NeedsCsvQuoting(const std::string_view a_field, const char delimiter) {
+    return delimiter == '\\' or delimiter == '.' or a_field == "\\." or
+           internal::findCsvSpecialChar(a_field, delimiter) != std::string_view::npos;
+}
+
+void AppendCsvField(OutputBuffer &out, std::string_view a_field, const char delimiter) {
+    if (not NeedsCsvQuoting(a_field, delimiter)) {
+        out.Append(a_field);
+        return;
+    }
+
+    out.Append(QUOTE);
+    for (auto quote_position = a_field.find(QUOTE);
+         quote_position != std::string_view::npos;
+         quote_position = a_field.find(QUOTE)) {
+        out.Append(a_field.substr(0, quote_position + 1)).Append(QUOTE);
+        a_field.remove_prefix(quote_position + 1);
+    }
+    out.Append(a_field).Append(QUOTE);
+}
+
+std::vector<std::string_view> SplitCsvRecords(const std::string_view data,
+                                              const std::size_t part_count) {
+    std::vector<std::string_view> parts;
+    const auto target_size = data.size() / std::max<std::size_t>(part_count, 1);
+
+    std::size_t begin = 0;
+    std::size_t position = 0;
+    auto in_quotes = false;
+    while (parts.size() + 1 < part_count and position < data.size()) {
+        const auto target = begin + target_size;
+        // Quotes and line feeds are found by the same scan as for output quoting.
+        const auto found = internal::findCsvSpecialChar(data.substr(position), '\n');
+        if (found == std::string_view::npos) {
+            break;
+        }
+
+        position += found;
+        const auto c = data[position++];
+        if (c == QUOTE) {
+            in_quotes = not in_quotes;
+        } else if (c == '\n' and not in_quotes and position >= target and
+                   position < data.size()) {
+            parts.push_back(data.substr(begin, position - begin));
+            begin = position;
+        }
+    }
+
+    if (begin < data.size()) {
+        parts.push_back(data.substr(begin));
+    }
+
+    return parts;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+
+namespace psqlxx {
+
+class OutputBuffer;
+
+
+/**
+ * A field is quoted, as psql does, if it contains the delimiter, a double quote,
+ * CR or LF; if it is exactly "\."; or if the delimiter is '\' or '.'.
+ */
+[[nodiscard]]
+bool NeedsCsvQuoting(const std::string_view a_field, const char delimiter);
+
+/**
+ * Appends a_field in RFC 4180 form, with embedded double quotes doubled when quoted.
+ */
+void AppendCsvField(OutputBuffer &out, const std::string_view a_field,
+                    const char delimiter);
+
+/**
+ * Splits CSV data into at most part_count parts of similar size, which end at record
+ * boundaries, i.e. after a line feed which is not inside a quoted field.
+ */
+[[nodiscard]]
+std::vector<std::string_view> SplitCsvRecords(const std::string_view data,
+                                              const std::size_t part_count);
+
+
+namespace internal {
+
+/**
+ * @return  The position of the first delimiter, double quote, CR or LF; or npos.
+ */
+[[nodiscard]]
+std::size_t findCsvSpecialChar(const std::string_view a_field, const char delimiter);
+
+[[nodiscard]]
+std::size_t findCsvSpecialCharScalar(const std::string_view a_field,
+                                     const char delimiter);
+
+}//namespace internal
+
+}//namespace psqlxx
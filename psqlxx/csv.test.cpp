@@ -0,0 +1,95 @@
+#include <psqlxx/csv.hpp>
+#include <psqlxx/output_buffer.hpp>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+auto toCsvField(const std::string_view a_field, const char delimiter = ',') {
+    std::ostringstream out;
+    {
+        OutputBuffer buffer{out};
+        AppendCsvField(buffer, a_field, delimiter);
+    }
+    return out.str();
+}
+
+}
+
+
+TEST(NeedsCsvQuotingTests, ReturnFalseIfGivenPlainField) {
+    ASSERT_FALSE(NeedsCsvQuoting("", ','));
+    ASSERT_FALSE(NeedsCsvQuoting("plain text; with 'quotes'", ','));
+}
+
+TEST(NeedsCsvQuotingTests, ReturnTrueIfGivenSpecialChars) {
+    ASSERT_TRUE(NeedsCsvQuoting("a,b", ','));
+    ASSERT_TRUE(NeedsCsvQuoting("a\"b", ','));
+    ASSERT_TRUE(NeedsCsvQuoting("a\rb", ','));
+    ASSERT_TRUE(NeedsCsvQuoting("a\nb", ','));
+    ASSERT_TRUE(NeedsCsvQuoting("a|b", '|'));
+}
+
+TEST(NeedsCsvQuotingTests, ReturnTrueIfGivenEndOfDataMarker) {
+    ASSERT_TRUE(NeedsCsvQuoting("\\.", ','));
+    ASSERT_TRUE(NeedsCsvQuoting("plain", '.'));
+}
+
+TEST(FindCsvSpecialCharTests, AgreeWithScalarAtEveryPosition) {
+    for (const auto special : {',', '"', '\r', '\n'}) {
+        for (std::size_t size = 0; size < 100; ++size) {
+            for (std::size_t position = 0; position <= size; ++position) {
+                std::string a_field(size, 'x');
+                if (position < size) {
+                    a_field[position] = special;
+                }
+                ASSERT_EQ(internal::findCsvSpecialCharScalar(a_field, ','),
+                          internal::findCsvSpecialChar(a_field, ','));
+            }
+        }
+    }
+}
+
+TEST(AppendCsvFieldTests, CopyPlainFieldAsIs) {
+    ASSERT_EQ("plain", toCsvField("plain"));
+}
+
+TEST(AppendCsvFieldTests, QuoteFieldWithDelimiter) {
+    ASSERT_EQ("\"a,b\"", toCsvField("a,b"));
+}
+
+TEST(AppendCsvFieldTests, DoubleEmbeddedQuotes) {
+    ASSERT_EQ(R"("say ""hi"", ""bye""")", toCsvField(R"(say "hi", "bye")"));
+    ASSERT_EQ(R"("""")", toCsvField(R"(")"));
+}
+
+TEST(SplitCsvRecordsTests, ReturnNoPartsIfGivenNoData) {
+    ASSERT_TRUE(SplitCsvRecords("", 4).empty());
+}
+
+TEST(SplitCsvRecordsTests, ReturnWholeDataIfGivenOnePart) {
+    const std::vector<std::string_view> expected{"a,b\n1,2\n"};
+    ASSERT_EQ(expected, SplitCsvRecords("a,b\n1,2\n", 1));
+}
+
+TEST(SplitCsvRecordsTests, CanSplitAtRecordBoundaries) {
+    const std::vector<std::string_view> expected{"a,b\n1,2\n", "3,4\n"};
+    ASSERT_EQ(expected, SplitCsvRecords("a,b\n1,2\n3,4\n", 2));
+}
+
+TEST(SplitCsvRecordsTests, CanKeepQuotedLineFeedsInTheirRecords) {
+    const std::vector<std::string_view> expected{"\"x\ny\",1\n", "\"\"\"\n\",2\n"};
+    ASSERT_EQ(expected, SplitCsvRecords("\"x\ny\",1\n\"\"\"\n\",2\n", 2));
+}
+
+TEST(SplitCsvRecordsTests, ReturnOnePartPerRecordIfGivenMorePartsThanRecords) {
+    const std::vector<std::string_view> expected{"1\n", "2\n", "3"};
+    ASSERT_EQ(expected, SplitCsvRecords("1\n2\n3", 8));
+}
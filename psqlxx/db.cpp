@@ -1,10 +1,28 @@
 #include <psqlxx/db.hpp>
+#include <psqlxx/binary_decoder.hpp>
+#include <psqlxx/bounded_queue.hpp>
+#include <psqlxx/connect_race.hpp>
+#include <psqlxx/csv.hpp>
+#include <psqlxx/mapped_file.hpp>
 #include <psqlxx/string_utils.hpp>
+#include <psqlxx/task_graph.hpp>
+#include <psqlxx/trace.hpp>
 
+#include <poll.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <condition_variable>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 
 #include <cxxopts.hpp>
 #include <pqxx/pqxx>
@@ -20,6 +38,188 @@ inline std::string_view getTransactionName() {
     return "psqlxx";
 }
 
+[[nodiscard]]
+inline std::string_view getCursorName() {
+    return "psqlxx_cursor";
+}
+
+/**
+ * Number of batches, or output blocks, allowed to wait between two pipeline stages.
+ */
+[[nodiscard]]
+inline constexpr std::size_t getPipelineDepth() {
+    return 4;
+}
+
+/**
+ * Number of statements allowed to wait for their results in a pipeline.
+ */
+[[nodiscard]]
+inline constexpr std::size_t getPipelineWindow() {
+    return 256;
+}
+
+/**
+ * Largest piece of data handed to libpq in one PQputCopyData() call.
+ */
+[[nodiscard]]
+inline constexpr std::size_t getCopyBlockSize() {
+    return 1024 * 1024;
+}
+
+/**
+ * @return  true if the floats of a_connection are output with shortest round-trip digits,
+ *          as the binary decoder prints them.
+ */
+[[nodiscard]]
+bool hasShortestFloatOutput(PGconn *a_connection) {
+    // Not reported by the server on change, so asked for.
+    const pq::ResultPtr a_result{PQexec(a_connection, "SHOW extra_float_digits")};
+    if (PQresultStatus(a_result.get()) != PGRES_TUPLES_OK or PQntuples(a_result.get()) != 1) {
+        return false;
+    }
+    return std::atoi(PQgetvalue(a_result.get(), 0, 0)) > 0;
+}
+
+/**
+ * @return  true if every column of the described statement can be decoded from binary
+ *          to the text the server would send.
+ */
+[[nodiscard]]
+bool canDecodeBinary(PGconn *a_connection, const PGresult *description,
+                     const TypeMap &type_map) {
+    const auto *const date_style = PQparameterStatus(a_connection, "DateStyle");
+    const auto iso_dates = date_style and StartsWith(date_style, "ISO");
+
+    auto has_floats = false;
+    for (int i = 0; i < PQnfields(description); ++i) {
+        const auto type_iter = type_map.find(PQftype(description, i));
+        if (type_iter == type_map.cend() or not GetBinaryDecoder(type_iter->second) or
+            (IsDateTimeType(type_iter->second) and not iso_dates)) {
+            return false;
+        }
+        has_floats = has_floats or type_iter->second == "float4" or type_iter->second == "float8";
+    }
+
+    return not has_floats or hasShortestFloatOutput(a_connection);
+}
+
+/**
+ * @return  The rows a_result affected, -1 if unknown.
+ */
+[[nodiscard]]
+std::int64_t getAffectedRows(PGresult *a_result) {
+    const std::string_view affected_rows = PQcmdTuples(a_result);
+    return affected_rows.empty() ? -1 : std::stoll(std::string{affected_rows});
+}
+
+[[nodiscard]]
+inline bool isWordChar(const char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) or c == '_' or c == '$' or
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+/**
+ * @return  Whether query may write, through SELECT INTO or a data-modifying WITH, which
+ *          neither DECLARE nor COPY takes. Words in quotes and comments are skipped, any
+ *          other mention counts, such as of FOR UPDATE, so as to rather run a query plainly.
+ */
+[[nodiscard]]
+bool mayWrite(const std::string_view query) {
+    std::size_t i = 0;
+    while (i < query.size()) {
+        std::size_t end = i + 1;
+        if (query[i] == '\'' or query[i] == '"') {
+            end = query.find(query[i], i + 1);
+            end = end == std::string_view::npos ? end : end + 1;
+        } else if (query.compare(i, 2, "--") == 0) {
+            end = query.find('\n', i);
+        } else if (query.compare(i, 2, "/*") == 0) {
+            end = query.find("*/", i + 2);
+            end = end == std::string_view::npos ? end : end + 2;
+        } else if (isWordChar(query[i])) {
+            while (end < query.size() and isWordChar(query[end])) {
+                ++end;
+            }
+            const auto word = query.substr(i, end - i);
+            for (const auto writing : {"into", "insert", "update", "delete", "merge"}) {
+                if (EqualsIgnoreCase(word, writing)) {
+                    return true;
+                }
+            }
+        }
+        i = end;
+    }
+
+    return false;
+}
+
+/**
+ * Takes a connection out of pipeline mode, and back to blocking, once it goes out of scope,
+ * however the pipeline ended. Results still due are read and dropped; if that fails, the
+ * connection is reset and on_reset is called.
+ */
+class PipelineGuard {
+    PGconn *m_connection;
+    std::function<void()> m_on_reset;
+
+    [[nodiscard]]
+    bool exitPipelineMode() const {
+        if (PQsetnonblocking(m_connection, 0) != 0) {
+            return false;
+        }
+        if (PQexitPipelineMode(m_connection) == 1) {
+            return true;
+        }
+        // Ends what was sent after the last sync, so that all due results arrive.
+        if (PQpipelineSync(m_connection) != 1) {
+            return false;
+        }
+        while (PQexitPipelineMode(m_connection) != 1) {
+            const pq::ResultPtr a_result{PQgetResult(m_connection)};
+            if (PQstatus(m_connection) != CONNECTION_OK) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    PipelineGuard(PGconn *a_connection, std::function<void()> on_reset):
+        m_connection(a_connection), m_on_reset(std::move(on_reset)) {
+    }
+    PipelineGuard(const PipelineGuard &) = delete;
+    PipelineGuard &operator=(const PipelineGuard &) = delete;
+
+    ~PipelineGuard() {
+        if (exitPipelineMode()) {
+            return;
+        }
+
+        std::cerr << PQerrorMessage(m_connection) << "Resetting the connection... ";
+        PQreset(m_connection);
+        if (PQstatus(m_connection) != CONNECTION_OK) {
+            std::cerr << PQerrorMessage(m_connection) << std::endl;
+            return;
+        }
+        std::cerr << "Succeeded." << std::endl;
+        m_on_reset();
+    }
+};
+
+/**
+ * Rebuilds a_connection around its own libpq connection, which pqxx does not expose.
+ *
+ * @return  The libpq connection, which a_connection still owns.
+ */
+[[nodiscard]]
+PGconn *exposeRawConnection(std::unique_ptr<pqxx::connection> &a_connection) {
+    auto *const raw_connection = std::move(*a_connection).release_raw_connection();
+    a_connection = std::make_unique<pqxx::connection>(
+                       pqxx::connection::seize_raw_connection(raw_connection));
+    return raw_connection;
+}
+
 [[nodiscard]]
 inline auto
 overridePasswordFromPrompt(std::string connection_string) {
@@ -27,6 +227,15 @@ overridePasswordFromPrompt(std::string connection_string) {
     return internal::overridePassword(std::move(connection_string), password);
 }
 
+/**
+ * Connects to the host of connection_string which answers first, if it names several.
+ */
+[[nodiscard]]
+inline auto
+connectToFastestHost(const std::string &connection_string) {
+    return std::make_unique<pqxx::connection>(ConnectToFastestHost(connection_string));
+}
+
 [[nodiscard]]
 inline auto
 concatenateKeyValue(std::string key, std::string value) {
@@ -35,14 +244,248 @@ concatenateKeyValue(std::string key, std::string value) {
 
 [[nodiscard]]
 inline auto
-doTransaction(const DbProxy &proxy,
-              const char **words, const int word_count) {
+joinWords(const char **words, const int word_count) {
     std::stringstream query;
     for (int i = 0; i < word_count; ++i) {
         query << words[i] << " ";
     }
 
-    return ToCommandResult(proxy.DoTransaction(query.str()));
+    return query.str();
+}
+
+[[nodiscard]]
+inline auto
+doTransaction(const DbProxy &proxy,
+              const char **words, const int word_count) {
+    return ToCommandResult(proxy.DoTransaction(joinWords(words, word_count)));
+}
+
+[[nodiscard]]
+inline auto
+copyOut(const DbProxy &proxy, const char **words, const int word_count) {
+    if (word_count < 3) {
+        std::cerr << "Command (" << words[0] << ") failed: Expected FORMAT and QUERY." << std::endl;
+        return CommandResult::failure;
+    }
+
+    return ToCommandResult(proxy.CopyOut(joinWords(words + 2, word_count - 2), words[1]));
+}
+
+/**
+ * @return  false after printing the error, if value is not a positive number.
+ */
+[[nodiscard]]
+bool parseJobCount(const std::string_view command, const std::string_view value,
+                   std::size_t &jobs) {
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), jobs);
+    if (error != std::errc{} or end != value.data() + value.size() or jobs == 0) {
+        std::cerr << "Command (" << command << ") failed: Invalid number of jobs '" <<
+                  value << "'." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+[[nodiscard]]
+inline auto
+startJob(const DbProxy &proxy, const char **words, const int word_count) {
+    if (word_count < 2) {
+        std::cerr << "Command (" << words[0] << ") failed: Expected QUERY." << std::endl;
+        return CommandResult::failure;
+    }
+
+    proxy.StartJob(joinWords(words + 1, word_count - 1));
+    return CommandResult::success;
+}
+
+[[nodiscard]]
+inline auto
+collectJob(const DbProxy &proxy, const char **words, const int word_count) {
+    std::optional<std::size_t> id;
+    if (word_count > 1) {
+        const std::string_view value{words[1]};
+        std::size_t parsed_id = 0;
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(),
+                                                  parsed_id);
+        if (error != std::errc{} or end != value.data() + value.size()) {
+            std::cerr << "Command (" << words[0] << ") failed: Invalid job id '" << value <<
+                      "'." << std::endl;
+            return CommandResult::failure;
+        }
+        id = parsed_id;
+    }
+
+    return ToCommandResult(proxy.CollectJob(id));
+}
+
+[[nodiscard]]
+inline auto
+copyIn(const DbProxy &proxy, const char **words, const int word_count) {
+    if (word_count < 3) {
+        std::cerr << "Command (" << words[0] << ") failed: Expected TABLE and FILE." << std::endl;
+        return CommandResult::failure;
+    }
+
+    std::size_t jobs = 1;
+    auto header = false;
+    for (int i = 3; i < word_count; ++i) {
+        const std::string_view option{words[i]};
+        if (option == "--header") {
+            header = true;
+        } else if (option == "--jobs" and i + 1 < word_count) {
+            if (not parseJobCount(words[0], words[++i], jobs)) {
+                return CommandResult::failure;
+            }
+        } else {
+            std::cerr << "Command (" << words[0] << ") failed: Unknown option '" << option <<
+                      "'." << std::endl;
+            return CommandResult::failure;
+        }
+    }
+
+    return ToCommandResult(proxy.CopyIn(words[1], words[2], jobs, header));
+}
+
+[[nodiscard]]
+inline auto
+dumpTable(const DbProxy &proxy, const char **words, const int word_count) {
+    if (word_count < 3) {
+        std::cerr << "Command (" << words[0] << ") failed: Expected TABLE and DIR." << std::endl;
+        return CommandResult::failure;
+    }
+
+    std::size_t jobs = 1;
+    for (int i = 3; i < word_count; ++i) {
+        const std::string_view option{words[i]};
+        if (option == "--jobs" and i + 1 < word_count) {
+            if (not parseJobCount(words[0], words[++i], jobs)) {
+                return CommandResult::failure;
+            }
+        } else {
+            std::cerr << "Command (" << words[0] << ") failed: Unknown option '" << option <<
+                      "'." << std::endl;
+            return CommandResult::failure;
+        }
+    }
+
+    return ToCommandResult(proxy.DumpTable(words[1], words[2], jobs));
+}
+
+[[nodiscard]]
+inline auto
+setTiming(const DbProxy &proxy, const char **words, const int word_count) {
+    if (word_count == 1) {
+        proxy.SetTiming(not proxy.GetTiming());
+    } else if (EqualsIgnoreCase(words[1], "on")) {
+        proxy.SetTiming(true);
+    } else if (EqualsIgnoreCase(words[1], "off")) {
+        proxy.SetTiming(false);
+    } else {
+        std::cerr << "Command (" << words[0] << ") failed: Expected on or off, but '" <<
+                  words[1] << "' was given." << std::endl;
+        return CommandResult::failure;
+    }
+
+    std::cerr << "Timing is " << (proxy.GetTiming() ? "on." : "off.") << std::endl;
+    return CommandResult::success;
+}
+
+[[nodiscard]]
+inline std::size_t getResultBytes(const pqxx::result &a_result) {
+    std::size_t bytes = 0;
+    for (const auto &a_row : a_result) {
+        for (const auto &a_field : a_row) {
+            bytes += a_field.size();
+        }
+    }
+    return bytes;
+}
+
+[[nodiscard]]
+inline std::size_t getResultBytes(const PqResult &a_result) {
+    return a_result.MemorySize();
+}
+
+[[nodiscard]]
+inline auto
+buildCopyInSql(const std::string_view table, const bool header) {
+    return SpaceJoiner("COPY", table, "FROM STDIN (FORMAT csv", header ? ", HEADER)" : ")");
+}
+
+/**
+ * Streams one part of a CSV file, over a connection of its own.
+ */
+[[nodiscard]]
+bool copyPartIn(const std::string &connection_string, const std::string &copy_sql,
+                std::string_view part) {
+    const auto a_connection = pq::Connect(connection_string);
+    if (not a_connection) {
+        return false;
+    }
+    auto *const raw_connection = a_connection.get();
+
+    const pq::ResultPtr copy_result{PQexec(raw_connection, copy_sql.c_str())};
+    if (not pq::CheckResult(raw_connection, copy_result.get())) {
+        return false;
+    }
+
+    while (not part.empty()) {
+        const auto block_size = std::min(part.size(), getCopyBlockSize());
+        if (PQputCopyData(raw_connection, part.data(), static_cast<int>(block_size)) != 1) {
+            std::cerr << PQerrorMessage(raw_connection) << std::endl;
+            return false;
+        }
+        part.remove_prefix(block_size);
+    }
+
+    if (PQputCopyEnd(raw_connection, nullptr) != 1) {
+        std::cerr << PQerrorMessage(raw_connection) << std::endl;
+        return false;
+    }
+
+    return pq::FinishCommand(raw_connection);
+}
+
+[[nodiscard]]
+inline auto
+getDumpPartPath(const std::string &directory, std::string table, const std::size_t part) {
+    std::replace(table.begin(), table.end(), '/', '_');
+    return std::filesystem::path{directory} / (table + ".part" + std::to_string(part) + ".csv");
+}
+
+/**
+ * Copies out one range of a table, in the exported snapshot, over a connection of its own.
+ */
+[[nodiscard]]
+bool dumpPart(const std::string &connection_string, const std::string &snapshot,
+              const std::string_view query, const std::filesystem::path &path) {
+    const auto a_connection = pq::Connect(connection_string);
+    if (not a_connection) {
+        return false;
+    }
+    auto *const raw_connection = a_connection.get();
+
+    if (not pq::ExecCommand(raw_connection, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY") or
+        not pq::ExecCommand(raw_connection, "SET TRANSACTION SNAPSHOT '" + snapshot + "'")) {
+        return false;
+    }
+
+    std::ofstream out{path, std::ofstream::out | std::ofstream::binary};
+    if (not out) {
+        std::cerr << "Failed to open out file '" << path.string() <<
+                  "': " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    return pq::CopyOut(raw_connection,
+                       SpaceJoiner("COPY (", query, ") TO STDOUT (FORMAT csv, HEADER)"), out) and
+           pq::ExecCommand(raw_connection, "COMMIT");
+}
+
+[[nodiscard]]
+inline auto validCopyFormat(const std::string_view format) {
+    return EqualsIgnoreCase(format, "csv") or EqualsIgnoreCase(format, "text") or
+           EqualsIgnoreCase(format, "binary");
 }
 
 [[nodiscard]]
@@ -111,6 +554,12 @@ void addConnectionOptions(cxxopts::Options &options) {
      cxxopts::value<std::string>()->default_value(""))
     ("w,no-password", "never prompt for password",
      cxxopts::value<bool>()->default_value("false"))
+    ("reconnect-attempts",
+     "once the connection is lost, try N times to reconnect and restore the session settings, with growing delays",
+     cxxopts::value<std::size_t>()->default_value("5"), "N")
+    ("keepalive-interval",
+     "probe the connection after every SECONDS idle at the prompt, reconnecting if it has been lost; 0 to not probe",
+     cxxopts::value<std::size_t>()->default_value("60"), "SECONDS")
     ;
 }
 
@@ -120,6 +569,8 @@ auto handleConnectionOptions(const cxxopts::ParseResult &parsed_options) {
 
     options.base_connection_string = parsed_options["connection-string"].as<std::string>();
     options.prompt_for_password = not parsed_options["no-password"].as<bool>();
+    options.reconnect_attempts = parsed_options["reconnect-attempts"].as<std::size_t>();
+    options.keepalive_interval_s = parsed_options["keepalive-interval"].as<std::size_t>();
 
     return options;
 }
@@ -129,6 +580,19 @@ auto handleConnectionOptions(const cxxopts::ParseResult &parsed_options) {
 
 namespace psqlxx {
 
+bool IsTransactionControl(std::string_view sql_cmd) {
+    const auto first_keyword = PopKeyword(sql_cmd);
+    for (const auto keyword : {"begin", "start", "commit", "end", "rollback", "abort",
+                               "savepoint", "release"}) {
+        if (EqualsIgnoreCase(first_keyword, keyword)) {
+            return true;
+        }
+    }
+
+    return EqualsIgnoreCase(first_keyword, "prepare") and
+           EqualsIgnoreCase(PopKeyword(sql_cmd), "transaction");
+}
+
 namespace internal {
 
 std::string overridePassword(std::string connection_string,
@@ -152,16 +616,23 @@ std::string overridePassword(std::string connection_string,
                                                   std::move(password));
 }
 
-std::unique_ptr<pqxx::connection> makeConnection(const ConnectionOptions &options) {
+std::unique_ptr<pqxx::connection> makeConnection(const ConnectionOptions &options,
+                                                 std::string *connection_string) {
+    const TraceSpan span{"makeConnection"};
     for (bool original_tried = false; true; original_tried = true) {
         try {
+            auto tried_connection_string = options.base_connection_string;
             if (original_tried and options.prompt_for_password) {
-                const auto connection_string =
-                    overridePasswordFromPrompt(options.base_connection_string);
-                return std::make_unique<pqxx::connection>(connection_string);
-            } else {
-                return std::make_unique<pqxx::connection>(options.base_connection_string);
+                tried_connection_string =
+                    overridePasswordFromPrompt(std::move(tried_connection_string));
             }
+
+            auto a_connection = connectToFastestHost(tried_connection_string);
+            // With all of its hosts, so that reconnecting can fail over to another.
+            if (connection_string) {
+                *connection_string = std::move(tried_connection_string);
+            }
+            return a_connection;
         } catch (const pqxx::broken_connection &e) {
             if (original_tried or not strstr(e.what(), "no password supplied")) {
                 std::cerr << e.what() << std::endl;
@@ -173,13 +644,91 @@ std::unique_ptr<pqxx::connection> makeConnection(const ConnectionOptions &option
     return {};
 }
 
+std::string_view toCursorQuery(std::string_view sql_cmd) {
+    constexpr std::string_view WHITESPACES = " \t\n\r\f\v";
+
+    const auto begin = sql_cmd.find_first_not_of(WHITESPACES);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    sql_cmd.remove_prefix(begin);
+    sql_cmd = sql_cmd.substr(0, sql_cmd.find_last_not_of(";" + std::string{WHITESPACES}) + 1);
+
+    if (sql_cmd.find(';') != std::string_view::npos) {
+        return {};
+    }
+
+    const auto keyword = sql_cmd.substr(0, sql_cmd.find_first_of("(" + std::string{WHITESPACES}));
+    for (const auto streamable : {"select", "values", "table", "with"}) {
+        if (EqualsIgnoreCase(keyword, streamable)) {
+            return mayWrite(sql_cmd) ? std::string_view{} : sql_cmd;
+        }
+    }
+
+    return {};
+}
+
+std::chrono::milliseconds getReconnectDelay(const std::size_t attempt) {
+    constexpr std::chrono::milliseconds FIRST_DELAY{100};
+    constexpr std::chrono::milliseconds MAX_DELAY{5000};
+
+    // Shifting further would only overflow.
+    if (attempt >= 16) {
+        return MAX_DELAY;
+    }
+    return std::min(FIRST_DELAY * (1 << attempt), MAX_DELAY);
+}
+
+std::vector<std::string> buildCtidRangeQueries(const std::string_view table,
+                                               const std::size_t page_count,
+                                               const std::size_t part_count) {
+    const auto range_count =
+        std::clamp<std::size_t>(part_count, 1, std::max<std::size_t>(page_count, 1));
+
+    const auto page_bound = [](const std::string_view op, const std::size_t page) {
+        return SpaceJoiner("ctid", op, "'(" + std::to_string(page) + ",0)'::tid");
+    };
+
+    std::vector<std::string> queries;
+    queries.reserve(range_count);
+    for (std::size_t i = 0; i < range_count; ++i) {
+        auto query = SpaceJoiner("SELECT * FROM", table);
+        if (range_count > 1) {
+            const auto first_page = page_count * i / range_count;
+            const auto end_page = page_count * (i + 1) / range_count;
+            if (i == 0) {
+                query = SpaceJoiner(query, "WHERE", page_bound("<", end_page));
+            } else if (i + 1 == range_count) {
+                query = SpaceJoiner(query, "WHERE", page_bound(">=", first_page));
+            } else {
+                query = SpaceJoiner(query, "WHERE", page_bound(">=", first_page), "AND",
+                                    page_bound("<", end_page));
+            }
+        }
+        queries.push_back(std::move(query));
+    }
+
+    return queries;
+}
+
 }//namespace internal
 
 DbProxy::DbProxy(DbProxyOptions options): m_options(std::move(options)),
-    m_out(std::cout.rdbuf()){
+    m_out(std::cout.rdbuf()),
+    m_timing_enabled(m_options.timing),
+    m_pool([this] {
+        return std::make_unique<pqxx::connection>(m_connection_string);
+    }, [](const pqxx::connection &a_connection) {
+        return a_connection.is_open();
+    }),
+    m_idle_probe(std::chrono::seconds{m_options.connection_options.keepalive_interval_s}) {
 
     connect();
 
+    if (not m_options.capture_file.empty()) {
+        m_capture = std::make_unique<WorkloadCapture>(m_options.capture_file);
+    }
+
     if (not m_options.format_options.out_file.empty()) {
         m_out_file.open(m_options.format_options.out_file, std::ofstream::out);
         if (m_out_file) {
@@ -192,9 +741,21 @@ DbProxy::DbProxy(DbProxyOptions options): m_options(std::move(options)),
     }
 }
 
+DbProxy::~DbProxy() {
+    const auto running_count = m_jobs.RunningCount();
+    if (running_count > 0) {
+        std::cerr << "Waiting for " << running_count << " background job(s) to finish." <<
+                  std::endl;
+    }
+}
+
 void DbProxy::connect() {
-    m_connection = internal::makeConnection(m_options.connection_options);
+    const auto start = StatementTiming::Clock::now();
+    m_connection = internal::makeConnection(m_options.connection_options,
+                                            &m_connection_string);
+    m_metrics.SetConnectTime(StatementTiming::Clock::now() - start);
     if (m_connection) {
+        m_session_connection = exposeRawConnection(m_connection);
         initTypeMap();
     }
 }
@@ -211,13 +772,17 @@ bool DbProxy::PrintConnectionInfo() const {
 }
 
 std::string DbProxy::GetDbName() const {
+    // Called by the prompt, while a probe may be reconnecting.
+    const std::lock_guard lock{m_connection_mutex};
     if (m_connection)
         return m_connection->dbname();
     return "";
 }
 
 void DbProxy::initTypeMap() {
-    if (not DoTransaction("select typname, oid from pg_type;",
+    const TraceSpan span{"initTypeMap"};
+    // Not through DoTransaction, as it is not the user's statement to capture or time.
+    if (not execute("select typname, oid from pg_type;",
                 [this](const pqxx::result &a_result) {
         for (const auto &row : a_result) {
             if (not row.empty()) {
@@ -230,19 +795,714 @@ void DbProxy::initTypeMap() {
     }
 }
 
+bool DbProxy::reconnect() const {
+    const auto &attempts = m_options.connection_options.reconnect_attempts;
+    if (attempts == 0) {
+        return false;
+    }
+
+    std::cerr << "The connection to the server was lost. Attempting reset: " << std::flush;
+    std::unique_ptr<pqxx::connection> a_connection;
+    std::string last_error;
+    for (std::size_t attempt = 0; attempt < attempts and not a_connection; ++attempt) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(internal::getReconnectDelay(attempt - 1));
+        }
+
+        try {
+            a_connection = connectToFastestHost(m_connection_string);
+        } catch (const std::exception &e) {
+            last_error = e.what();
+        }
+    }
+    if (not a_connection) {
+        std::cerr << "Failed." << std::endl << last_error << std::endl;
+        return false;
+    }
+
+    {
+        const std::lock_guard lock{m_connection_mutex};
+        m_session_connection = exposeRawConnection(a_connection);
+        m_connection = std::move(a_connection);
+    }
+    m_transaction_status = TransactionStatus::idle;
+    m_pending_session_changes.clear();
+    std::cerr << "Succeeded." << std::endl;
+
+    restoreSessionState();
+    return true;
+}
+
+void DbProxy::restoreSessionState() const {
+    for (const auto a_statement : m_session_state.Statements()) {
+        try {
+            pqxx::nontransaction a_transaction(*m_connection, getTransactionName());
+            (void) a_transaction.exec(a_statement);
+        } catch (const std::exception &e) {
+            std::cerr << "Failed to restore the session state with '" << a_statement << "': " <<
+                      e.what() << std::endl;
+        }
+    }
+}
+
+void DbProxy::probe() const {
+    // Probing would fail a transaction block which has failed already.
+    if (m_transaction_status != TransactionStatus::idle) {
+        return;
+    }
+
+    const std::lock_guard lock{m_connection_mutex};
+    try {
+        // An empty query makes a round trip, without the server running a statement.
+        pqxx::nontransaction a_transaction(*m_connection, getTransactionName());
+        (void) a_transaction.exec("");
+    } catch (const std::exception &) {
+        // A lost connection is reported when reconnecting, once the session is busy.
+    }
+}
+
+void DbProxy::updateTransactionStatus() const {
+    switch (PQtransactionStatus(m_session_connection)) {
+        case PQTRANS_INTRANS:
+            m_transaction_status = TransactionStatus::in_transaction;
+            break;
+        case PQTRANS_INERROR:
+            m_transaction_status = TransactionStatus::failed;
+            break;
+        default:
+            m_transaction_status = TransactionStatus::idle;
+            break;
+    }
+}
+
+void DbProxy::reconnectIfLost() const {
+    if (not m_connection->is_open()) {
+        (void) reconnect();
+    }
+}
+
+void DbProxy::recordSessionState(const std::string_view sql_cmd,
+                                 const TransactionStatus previous_status) const {
+    if (previous_status == TransactionStatus::idle and
+        m_transaction_status == TransactionStatus::idle) {
+        m_session_state.Record(sql_cmd);
+        return;
+    }
+
+    auto remaining = sql_cmd;
+    const auto keyword = PopKeyword(remaining);
+    const auto committed = previous_status == TransactionStatus::in_transaction and
+                           (EqualsIgnoreCase(keyword, "commit") or
+                            EqualsIgnoreCase(keyword, "end"));
+    if (committed) {
+        // Also by COMMIT AND CHAIN, which begins the next block right away.
+        for (const auto &a_change : m_pending_session_changes) {
+            m_session_state.Record(a_change);
+        }
+        m_pending_session_changes.clear();
+    }
+
+    if (m_transaction_status == TransactionStatus::in_transaction) {
+        if (not committed and SessionState::IsChange(sql_cmd)) {
+            m_pending_session_changes.emplace_back(sql_cmd);
+        }
+        return;
+    }
+
+    if (m_transaction_status == TransactionStatus::idle) {
+        m_pending_session_changes.clear();
+    }
+}
+
+QueryWatchdog::Watch DbProxy::watchStatement() const {
+    // Made on this thread, before the statement starts, as libpq only lets PQcancel() be
+    // called from others.
+    std::shared_ptr<PGcancel> a_cancel{PQgetCancel(m_session_connection), pq::CancelDeleter{}};
+    return m_watchdog.Begin([a_cancel] {
+        (void) pq::Cancel(a_cancel.get());
+    }, std::chrono::milliseconds{m_options.statement_timeout_ms});
+}
+
+template <typename Result>
+void DbProxy::printResult(const Result &a_result, const std::string_view title) const {
+    // Counting walks every field, which is only worth it for the timing line.
+    if (m_timing_enabled) {
+        m_timing.result_bytes = std::max(m_timing.result_bytes, getResultBytes(a_result));
+    }
+
+    // Formatting is timed as printing, without the writes it makes.
+    const auto write_before = m_timing.write;
+    const auto start = StatementTiming::Clock::now();
+    {
+        ResultPrinter printer{m_options.format_options, m_pg_type_map, [this](std::string & block) {
+            const PhaseTimer timer{m_timing.write};
+            m_out.write(block.data(), block.size());
+            m_out.flush();
+            m_metrics.AddBytesWritten(block.size());
+            block.clear();
+        }, title};
+        printer.Print(a_result);
+        printer.Finish();
+    }
+    m_timing.format += StatementTiming::Clock::now() - start - (m_timing.write - write_before);
+}
+
 void
 DbProxy::PrintResult(const pqxx::result &a_result, const std::string_view title) const {
-    psqlxx::PrintResult(a_result, m_options.format_options, m_pg_type_map, m_out, title);
+    printResult(a_result, title);
 }
 
-bool DbProxy::DoTransaction(const std::string_view sql_cmd,
-        const ResultHandler handler) const {
+void
+DbProxy::PrintResult(const PqResult &a_result, const std::string_view title) const {
+    printResult(a_result, title);
+}
+
+bool DbProxy::fetchInBatches(const std::string_view cursor_query) const {
+    BoundedQueue<pqxx::result> batch_queue{getPipelineDepth()};
+    BoundedQueue<std::string> block_queue{getPipelineDepth()};
+    std::atomic<bool> all_fetched{false};
+
+    // Stages overlap: this thread fetches, formatter formats and writer writes to m_out.
+    std::thread writer{[this, &block_queue] {
+        while (const auto block = block_queue.Pop()) {
+            const PhaseTimer timer{m_timing.write};
+            m_out.write(block->data(), block->size());
+            m_out.flush();
+            m_metrics.AddBytesWritten(block->size());
+        }
+    }};
+
+    std::thread formatter{[this, &batch_queue, &block_queue, &all_fetched] {
+        {
+            ResultPrinter printer{m_options.format_options, m_pg_type_map,
+            [&block_queue](std::string & block) {
+                block_queue.Push(std::exchange(block, std::string{}));
+            }};
+            while (const auto a_batch = batch_queue.Pop()) {
+                const PhaseTimer timer{m_timing.format};
+                printer.Print(*a_batch);
+            }
+            if (all_fetched) {
+                printer.Finish();
+            }
+        }
+        block_queue.Close();
+    }};
+
+    const auto succeeded = pqxx::perform([this, cursor_query, &batch_queue, &all_fetched] {
+        try {
+            // Until the first batch has arrived, time is spent waiting, then transferring.
+            std::optional<PhaseTimer> wait_timer{std::in_place, m_timing.wait};
+
+            // A cursor needs a transaction block: the user's, or one of its own.
+            std::unique_ptr<pqxx::transaction_base> a_transaction;
+            if (m_transaction_status == TransactionStatus::idle) {
+                a_transaction = std::make_unique<pqxx::work>(*m_connection, getTransactionName());
+            } else {
+                a_transaction = std::make_unique<pqxx::nontransaction>(*m_connection,
+                                                                       getTransactionName());
+            }
+            a_transaction->exec0(SpaceJoiner("DECLARE", getCursorName(), "NO SCROLL CURSOR FOR",
+                                             cursor_query));
+
+            const auto fetch_sql = SpaceJoiner("FETCH FORWARD", m_options.fetch_count,
+                                               "FROM", getCursorName());
+            for (auto more_rows = true; more_rows;) {
+                std::optional<PhaseTimer> transfer_timer;
+                if (not wait_timer) {
+                    transfer_timer.emplace(m_timing.transfer);
+                }
+                auto a_batch = [this, &a_transaction, &fetch_sql] {
+                    const auto watch = watchStatement();
+                    return a_transaction->exec(fetch_sql);
+                }();
+                wait_timer.reset();
+                transfer_timer.reset();
+
+                more_rows = static_cast<std::size_t>(a_batch.size()) == m_options.fetch_count;
+                if (m_timing_enabled) {
+                    m_timing.result_bytes = std::max(m_timing.result_bytes,
+                                                     getResultBytes(a_batch));
+                }
+                batch_queue.Push(std::move(a_batch));
+            }
+            all_fetched = true;
+
+            a_transaction->exec0(SpaceJoiner("CLOSE", getCursorName()));
+            a_transaction->commit();
+            return true;
+
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+    });
+
+    batch_queue.Close();
+    formatter.join();
+    writer.join();
+
+    return succeeded;
+}
+
+bool DbProxy::fetchInBinary(const std::string_view query) const {
+    const auto start = StatementTiming::Clock::now();
+    // On the session's own connection, which has its settings, temporary tables and locks.
+    auto *const raw_connection = m_session_connection;
+
+    // Describe first, as asking for binary only pays off if every column can be decoded.
+    const std::string query_str{query};
+    const pq::ResultPtr prepared{PQprepare(raw_connection, "", query_str.c_str(), 0, nullptr)};
+    if (not pq::CheckResult(raw_connection, prepared.get())) {
+        return false;
+    }
+    const pq::ResultPtr description{PQdescribePrepared(raw_connection, "")};
+    if (not pq::CheckResult(raw_connection, description.get())) {
+        return false;
+    }
+
+    const auto result_format =
+        canDecodeBinary(raw_connection, description.get(), m_pg_type_map) ? 1 : 0;
+    pq::ResultPtr a_result;
+    {
+        // Until the result is complete, the statement may be cancelled.
+        const auto watch = watchStatement();
+        if (PQsendQueryPrepared(raw_connection, "", 0, nullptr, nullptr, nullptr,
+                                result_format) != 1) {
+            std::cerr << PQerrorMessage(raw_connection) << std::endl;
+            return false;
+        }
+        if (not pq::WaitForInput(raw_connection)) {
+            return false;
+        }
+        const auto first_input = StatementTiming::Clock::now();
+        m_timing.wait += first_input - start;
+
+        a_result.reset(PQgetResult(raw_connection));
+        const auto command_finished = pq::FinishCommand(raw_connection);
+        m_timing.transfer += StatementTiming::Clock::now() - first_input;
+        if (not pq::CheckResult(raw_connection, a_result.get()) or not command_finished) {
+            return false;
+        }
+    }
+
+    m_row_count = PQntuples(a_result.get());
+    PrintResult(PqResult{std::move(a_result), m_pg_type_map});
+    return true;
+}
+
+bool DbProxy::CopyOut(const std::string_view query, const std::string_view format) const {
+    if (not validCopyFormat(format)) {
+        std::cerr << "Invalid COPY format '" << format <<
+                  "', expected csv, text or binary." << std::endl;
+        return false;
+    }
+
+    const auto copy_query = internal::toCursorQuery(query);
+    if (copy_query.empty()) {
+        std::cerr << "Only a single SELECT, VALUES, TABLE or WITH query can be copied out." <<
+                  std::endl;
+        return false;
+    }
+
+    // On the session's own connection, which has its settings and temporary tables.
+    auto *const raw_connection = m_session_connection;
+
+    auto copy_sql = SpaceJoiner("COPY (", copy_query, ") TO STDOUT (FORMAT", format);
+    if (EqualsIgnoreCase(format, "csv")) {
+        copy_sql += ", HEADER";
+    }
+    copy_sql += ")";
+
+    std::size_t bytes_written = 0;
+    const auto watch = watchStatement();
+    const auto succeeded = pq::CopyOut(raw_connection, copy_sql, m_out, &bytes_written);
+    m_metrics.AddBytesWritten(bytes_written);
+    return succeeded;
+}
+
+bool DbProxy::DoBatch(const std::vector<std::string_view> &statements,
+                      const bool stop_at_failure) const {
     assert(*this);
 
-    return pqxx::perform([this, sql_cmd, handler] {
+    if (statements.size() > 1 and m_transaction_status == TransactionStatus::idle) {
+        std::vector<pqxx::result> results;
+        results.reserve(statements.size());
+        // Of BEGIN, the statements and COMMIT, one more than the statements
+        std::vector<StatementTiming::Clock::time_point> starts;
+        starts.reserve(statements.size() + 1);
+        StatementTiming::Clock::time_point begin_start;
+        StatementTiming::Clock::time_point commit_end;
+        auto in_doubt = false;
+
+        const auto committed = pqxx::perform([this, &statements, &results, &starts,
+                                                    &begin_start, &commit_end, &in_doubt] {
+            try {
+                begin_start = StatementTiming::Clock::now();
+                pqxx::work a_work(*m_connection, getTransactionName());
+                for (const auto a_statement : statements) {
+                    const auto watch = watchStatement();
+                    starts.push_back(StatementTiming::Clock::now());
+                    results.push_back(a_work.exec(a_statement));
+                }
+                starts.push_back(StatementTiming::Clock::now());
+                a_work.commit();
+                commit_end = StatementTiming::Clock::now();
+                return true;
+
+            } catch (const pqxx::in_doubt_error &e) {
+                // Whether the batch was committed is unknown, so it must not be replayed.
+                std::cerr << e.what() << std::endl;
+                in_doubt = true;
+                return false;
+            } catch (const std::exception &) {
+                results.clear();
+                starts.clear();
+                return false;
+            }
+        });
+
+        if (committed) {
+            // Captured as the transaction block it ran in, which replays on one connection.
+            if (m_capture) {
+                m_capture->Record("BEGIN", begin_start, starts.front(), -1);
+            }
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                const auto row_count = results[i].affected_rows();
+                m_metrics.AddStatement(starts[i + 1] - starts[i], true, row_count);
+                if (m_capture) {
+                    m_capture->Record(statements[i], starts[i], starts[i + 1], row_count);
+                }
+                recordSessionState(statements[i], TransactionStatus::idle);
+                PrintResult(results[i]);
+            }
+            if (m_capture) {
+                m_capture->Record("COMMIT", starts.back(), commit_end, -1);
+            }
+        }
+        if (committed or in_doubt) {
+            return committed;
+        }
+    }
+
+    auto all_succeeded = true;
+    for (const auto a_statement : statements) {
+        all_succeeded = DoTransaction(a_statement) and all_succeeded;
+        if (not all_succeeded and stop_at_failure) {
+            break;
+        }
+    }
+    return all_succeeded;
+}
+
+bool DbProxy::RunPipeline(const std::vector<std::string> &statements) const {
+    // On the session's own connection, which has its settings and temporary tables.
+    auto *const raw_connection = m_session_connection;
+
+    if (PQenterPipelineMode(raw_connection) != 1) {
+        std::cerr << PQerrorMessage(raw_connection) << std::endl;
+        return false;
+    }
+
+    const auto succeeded = [&] {
+        // Leaves pipeline mode on every way out, a reset connection has lost the session state.
+        const PipelineGuard guard{raw_connection, [this] {
+            m_transaction_status = TransactionStatus::idle;
+            m_pending_session_changes.clear();
+            restoreSessionState();
+        }};
+
+        // Non-blocking, so that sending never waits on a server waiting for results to be read.
+        if (PQsetnonblocking(raw_connection, 1) != 0) {
+            std::cerr << PQerrorMessage(raw_connection) << std::endl;
+            return false;
+        }
+        // Until all statements have completed, the pipeline may be cancelled.
+        const auto watch = watchStatement();
+
+        auto all_succeeded = true;
+        auto statement_succeeded = true;
+        std::int64_t statement_row_count = -1;
+        std::size_t sent = 0;
+        std::size_t completed = 0;
+        // A statement's duration runs from when it was sent, or the previous one completed.
+        std::vector<StatementTiming::Clock::time_point> send_times(statements.size());
+        auto previous_completion = StatementTiming::Clock::now();
+        while (completed < statements.size()) {
+            for (; sent < statements.size() and sent - completed < getPipelineWindow(); ++sent) {
+                send_times[sent] = StatementTiming::Clock::now();
+                if (PQsendQueryParams(raw_connection, statements[sent].c_str(), 0, nullptr, nullptr,
+                                      nullptr, nullptr, 0) != 1 or
+                    PQpipelineSync(raw_connection) != 1) {
+                    std::cerr << PQerrorMessage(raw_connection) << std::endl;
+                    return false;
+                }
+            }
+
+            const auto flush_result = PQflush(raw_connection);
+            if (flush_result < 0) {
+                std::cerr << PQerrorMessage(raw_connection) << std::endl;
+                return false;
+            }
+
+            pollfd socket_fd{PQsocket(raw_connection), POLLIN, 0};
+            if (flush_result > 0) {
+                socket_fd.events |= POLLOUT;
+            }
+            if ((poll(&socket_fd, 1, -1) < 0 and errno != EINTR) or
+                ((socket_fd.revents & POLLIN) and not PQconsumeInput(raw_connection))) {
+                std::cerr << PQerrorMessage(raw_connection) << std::endl;
+                return false;
+            }
+
+            while (completed < sent and not PQisBusy(raw_connection)) {
+                pq::ResultPtr a_result{PQgetResult(raw_connection)};
+                if (not a_result) {
+                    // End of one statement's results, its sync follows.
+                    continue;
+                }
+
+                switch (PQresultStatus(a_result.get())) {
+                    case PGRES_PIPELINE_SYNC: {
+                        const auto now = StatementTiming::Clock::now();
+                        const auto start = std::max(send_times[completed], previous_completion);
+                        m_metrics.AddStatement(now - start, statement_succeeded,
+                                               statement_row_count);
+                        if (m_capture) {
+                            m_capture->Record(statements[completed], start, now,
+                                              statement_row_count);
+                        }
+                        previous_completion = now;
+
+                        all_succeeded = all_succeeded and statement_succeeded;
+                        statement_succeeded = true;
+                        statement_row_count = -1;
+                        ++completed;
+                        break;
+                    }
+                    case PGRES_TUPLES_OK:
+                        statement_row_count = PQntuples(a_result.get());
+                        PrintResult(PqResult{std::move(a_result), m_pg_type_map});
+                        break;
+                    default:
+                        statement_row_count = getAffectedRows(a_result.get());
+                        statement_succeeded = pq::CheckResult(raw_connection, a_result.get()) and
+                                              statement_succeeded;
+                        break;
+                }
+            }
+        }
+
+        return all_succeeded;
+    }();
+
+    // The statements may have begun or ended a transaction block.
+    updateTransactionStatus();
+    return succeeded;
+}
+
+bool DbProxy::CopyIn(const std::string_view table, const std::string &file_path,
+                     const std::size_t jobs, const bool header) const {
+    const MappedFile file{file_path};
+    if (not file) {
+        return false;
+    }
+
+    // Each part is parsed by the server on its own backend, so the load scales with jobs.
+    const auto parts = SplitCsvRecords(file.View(), jobs);
+    std::vector<char> succeeded(parts.size(), false);
+    std::vector<std::thread> threads;
+    threads.reserve(parts.size());
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        threads.emplace_back([this, table, header, &parts, &succeeded, i] {
+            succeeded[i] = copyPartIn(m_connection_string, buildCopyInSql(table, header and i == 0),
+                                      parts[i]);
+        });
+    }
+    for (auto &a_thread : threads) {
+        a_thread.join();
+    }
+
+    return std::all_of(succeeded.cbegin(), succeeded.cend(), [](const auto part_succeeded) {
+        return part_succeeded;
+    });
+}
+
+bool DbProxy::DumpTable(const std::string_view table, const std::string &directory,
+                        const std::size_t jobs) const {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create directory '" << directory << "': " << error.message() <<
+                  std::endl;
+        return false;
+    }
+
+    // The exported snapshot stays usable by the parts as long as this transaction is open.
+    const auto exporter = pq::Connect(m_connection_string);
+    if (not exporter or
+        not pq::ExecCommand(exporter.get(), "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY")) {
+        return false;
+    }
+
+    const std::string table_name{table};
+    const char *const parameters[] = {table_name.c_str()};
+    const pq::ResultPtr snapshot_result{PQexecParams(exporter.get(),
+        "SELECT pg_export_snapshot(), "
+        "pg_relation_size($1::regclass) / current_setting('block_size')::bigint",
+        1, nullptr, parameters, nullptr, nullptr, 0)};
+    if (not pq::CheckResult(exporter.get(), snapshot_result.get())) {
+        return false;
+    }
+    const std::string snapshot = PQgetvalue(snapshot_result.get(), 0, 0);
+    const auto page_count = std::strtoull(PQgetvalue(snapshot_result.get(), 0, 1), nullptr, 10);
+
+    const auto queries = internal::buildCtidRangeQueries(table, page_count, jobs);
+    std::vector<char> succeeded(queries.size(), false);
+    std::vector<std::thread> threads;
+    threads.reserve(queries.size());
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        threads.emplace_back([this, table, &directory, &snapshot, &queries, &succeeded, i] {
+            succeeded[i] = dumpPart(m_connection_string, snapshot, queries[i],
+                                    getDumpPartPath(directory, std::string{table}, i));
+        });
+    }
+    for (auto &a_thread : threads) {
+        a_thread.join();
+    }
+
+    return std::all_of(succeeded.cbegin(), succeeded.cend(), [](const auto part_succeeded) {
+        return part_succeeded;
+    }) and pq::ExecCommand(exporter.get(), "COMMIT");
+}
+
+bool DbProxy::RunInParallel(const std::vector<std::string_view> &statements,
+                            const std::vector<std::vector<std::size_t>> &dependencies,
+                            const std::size_t jobs) const {
+    assert(statements.size() == dependencies.size());
+
+    std::vector<std::unique_ptr<pqxx::connection>> connections;
+    try {
+        for (std::size_t i = 0; i < std::min(jobs, statements.size()); ++i) {
+            connections.push_back(std::make_unique<pqxx::connection>(m_connection_string));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+
+    struct Outcome {
+        std::optional<pqxx::result> result;
+        std::string error;
+        StatementTiming::Clock::duration duration{};
+        // As a statement it depends on failed, or was skipped
+        bool skipped = false;
+        bool done = false;
+    };
+    std::vector<Outcome> outcomes(statements.size());
+    // Kept apart from the outcomes, which are moved out once printed
+    std::vector<char> failed(statements.size(), false);
+    std::mutex outcomes_mutex;
+    std::condition_variable outcome_done;
+
+    std::thread graph_runner{[&] {
+        RunTaskGraph(dependencies, connections.size(), [&](const auto worker, const auto task) {
+            const TraceSpan span{"executeTask"};
+            Outcome an_outcome;
+            {
+                const std::lock_guard lock{outcomes_mutex};
+                an_outcome.skipped = std::any_of(dependencies[task].cbegin(),
+                                                 dependencies[task].cend(),
+                [&failed](const auto a_dependency) {
+                    return failed[a_dependency];
+                });
+            }
+            if (not an_outcome.skipped) {
+                const auto start = StatementTiming::Clock::now();
+                try {
+                    pqxx::nontransaction a_transaction(*connections[worker]);
+                    an_outcome.result = a_transaction.exec(statements[task]);
+                } catch (const std::exception &e) {
+                    an_outcome.error = e.what();
+                }
+                an_outcome.duration = StatementTiming::Clock::now() - start;
+            }
+            an_outcome.done = true;
+
+            {
+                const std::lock_guard lock{outcomes_mutex};
+                failed[task] = not an_outcome.result;
+                outcomes[task] = std::move(an_outcome);
+            }
+            outcome_done.notify_one();
+        });
+    }};
+
+    // Results are printed in script order, while later statements are still running.
+    auto all_succeeded = true;
+    std::size_t skipped_count = 0;
+    for (auto &an_outcome : outcomes) {
+        Outcome done_outcome;
+        {
+            std::unique_lock lock{outcomes_mutex};
+            outcome_done.wait(lock, [&an_outcome] {
+                return an_outcome.done;
+            });
+            done_outcome = std::move(an_outcome);
+        }
+
+        // Counted here, as the metrics are not shared with the workers.
+        if (not done_outcome.skipped) {
+            m_metrics.AddStatement(done_outcome.duration, done_outcome.result.has_value(),
+                                   done_outcome.result ? done_outcome.result->affected_rows() : -1);
+        }
+        if (done_outcome.result) {
+            PrintResult(*done_outcome.result);
+        } else if (done_outcome.skipped) {
+            const auto i = &an_outcome - outcomes.data();
+            std::cerr << "Skipped '" << statements[i] <<
+                      "', as a statement it depends on failed." << std::endl;
+            ++skipped_count;
+            all_succeeded = false;
+        } else {
+            std::cerr << done_outcome.error << std::endl;
+            all_succeeded = false;
+        }
+    }
+    graph_runner.join();
+
+    if (skipped_count > 0) {
+        std::cerr << skipped_count << " statement(s) skipped." << std::endl;
+    }
+
+    return all_succeeded;
+}
+
+bool DbProxy::execute(const std::string_view sql_cmd, const ResultHandler &handler) const {
+    const TraceSpan span{"execute"};
+    if (not handler and (m_options.fetch_count > 0 or not m_options.copy_format.empty() or
+                         m_options.binary_results)) {
+        const auto query = internal::toCursorQuery(sql_cmd);
+        if (not query.empty()) {
+            if (not m_options.copy_format.empty()) {
+                return CopyOut(query, m_options.copy_format);
+            }
+            if (m_options.fetch_count > 0) {
+                return fetchInBatches(query);
+            }
+            return fetchInBinary(query);
+        }
+    }
+
+    return pqxx::perform([this, sql_cmd, &handler] {
         try {
-            pqxx::work a_work(*(m_connection), getTransactionName());
-            const auto a_result = a_work.exec(sql_cmd);
+            // Each command commits on its own, unless the user has begun a transaction block.
+            pqxx::nontransaction a_transaction(*m_connection, getTransactionName());
+            const auto a_result = [this, &a_transaction, sql_cmd] {
+                const auto watch = watchStatement();
+                return a_transaction.exec(sql_cmd);
+            }();
+            m_row_count = a_result.affected_rows();
 
             if (handler) {
                 handler(a_result);
@@ -258,6 +1518,103 @@ bool DbProxy::DoTransaction(const std::string_view sql_cmd,
     });
 }
 
+bool DbProxy::ResetSession() const {
+    const auto ignore_result = [](const pqxx::result &) {};
+    if (m_transaction_status != TransactionStatus::idle and
+        not execute("ROLLBACK", ignore_result)) {
+        return false;
+    }
+    m_transaction_status = TransactionStatus::idle;
+    m_session_state.Clear();
+    m_pending_session_changes.clear();
+
+    return execute("DISCARD ALL", ignore_result);
+}
+
+std::future<pqxx::result> DbProxy::ExecuteAsync(std::string sql_cmd) const {
+    // Copied on this thread, which may change the session state while the job runs.
+    const auto state_statements = m_session_state.Statements();
+    std::vector<std::string> session_statements{state_statements.cbegin(),
+                                                state_statements.cend()};
+
+    return std::async(std::launch::async, [this, sql_cmd = std::move(sql_cmd),
+                                           session_statements = std::move(session_statements)] {
+        const TraceSpan span{"executeAsync"};
+        const auto a_lease = m_pool.Acquire();
+        pqxx::nontransaction a_transaction(*a_lease, getTransactionName());
+        // Discards what an earlier job left on the pooled connection, then restores the session's.
+        (void) a_transaction.exec("DISCARD ALL");
+        for (const auto &a_statement : session_statements) {
+            (void) a_transaction.exec(a_statement);
+        }
+        return a_transaction.exec(sql_cmd);
+    });
+}
+
+void DbProxy::StartJob(std::string sql_cmd) const {
+    auto a_result = ExecuteAsync(sql_cmd);
+    m_out << '[' << m_jobs.Start(std::move(sql_cmd), std::move(a_result)) << ']' << std::endl;
+}
+
+void DbProxy::PrintJobs() const {
+    m_jobs.List(m_out);
+    m_out.flush();
+}
+
+bool DbProxy::CollectJob(const std::optional<std::size_t> id) const {
+    auto a_job = m_jobs.Collect(id);
+    if (not a_job) {
+        std::cerr << "No such job." << std::endl;
+        return false;
+    }
+
+    try {
+        PrintResult(a_job->result.get(), "Job " + std::to_string(a_job->id));
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool DbProxy::DoTransaction(const std::string_view sql_cmd,
+        const ResultHandler handler) const {
+    assert(*this);
+
+    m_row_count = -1;
+    m_timing = {};
+    const auto start = StatementTiming::Clock::now();
+    const auto succeeded = execute(sql_cmd, handler);
+    const auto end = StatementTiming::Clock::now();
+
+    m_timing.total = end - start;
+    if (m_timing.wait == m_timing.wait.zero() and m_timing.transfer == m_timing.transfer.zero()) {
+        // The result arrived whole, so waiting for and transferring it are one phase.
+        m_timing.wait = std::max(m_timing.total - m_timing.format - m_timing.write,
+                                 m_timing.wait.zero());
+    }
+    m_stats.Add(m_timing, succeeded);
+    m_metrics.AddStatement(m_timing.total, succeeded, m_row_count);
+    if (m_timing_enabled) {
+        std::cerr << FormatStatementTiming(m_timing) << std::endl;
+    }
+
+    if (m_capture) {
+        m_capture->Record(sql_cmd, start, end, m_row_count);
+    }
+    const auto previous_status = m_transaction_status;
+    updateTransactionStatus();
+    if (succeeded) {
+        recordSessionState(sql_cmd, previous_status);
+    } else if (not m_connection->is_open()) {
+        (void) reconnect();
+    } else if (m_transaction_status == TransactionStatus::idle) {
+        // Such as a COMMIT which failed on a deferred constraint, and rolled back instead.
+        m_pending_session_changes.clear();
+    }
+    return succeeded;
+}
+
 void AddDbProxyOptions(cxxopts::Options &options) {
     addConnectionOptions(options);
 
@@ -268,8 +1625,44 @@ void AddDbProxyOptions(cxxopts::Options &options) {
      cxxopts::value<std::vector<std::string>>(), "COMMAND")
     ("f,command-file", "execute commands from file, then exit",
      cxxopts::value<std::string>()->default_value(""))
+    ("fetch-count",
+     "fetch and print SELECT results in batches of N rows through a cursor, 0 to fetch all rows at once",
+     cxxopts::value<std::size_t>()->default_value("0"), "N")
+    ("binary-results",
+     "retrieve SELECT results in binary format and decode them locally",
+     cxxopts::value<bool>()->default_value("false"))
+    ("pipeline",
+     "send -c commands, or -f file statements, through a libpq pipeline, continuing past failed ones",
+     cxxopts::value<bool>()->default_value("false"))
+    ("jobs",
+     "run -f file statements on N connections in parallel, ordered by their psqlxx: annotations",
+     cxxopts::value<std::size_t>()->default_value("1"), "N")
+    ("batch-size",
+     "run -f or -c statements in transactions of N statements, replaying a failed one statement by statement",
+     cxxopts::value<std::size_t>()->default_value("0"), "N")
+    ("statement-timeout",
+     "cancel statements which run longer than MS milliseconds, keeping the session; 0 for no timeout",
+     cxxopts::value<std::size_t>()->default_value("0"), "MS")
+    ("timing",
+     "print the time of each statement to stderr, split into wait, transfer, format and write phases",
+     cxxopts::value<bool>()->default_value("false"))
+    ("trace",
+     "record spans of connecting, command dispatch, execution, formatting and writing to FILE, in Chrome trace format",
+     cxxopts::value<std::string>()->default_value(""), "FILE")
+    ("metrics-file",
+     "after -c or -f, write metrics of the run to FILE for the node_exporter textfile collector",
+     cxxopts::value<std::string>()->default_value(""), "FILE")
+    ("capture",
+     "record each statement run, with its start offset, duration and row count, to FILE for --replay; not with --jobs",
+     cxxopts::value<std::string>()->default_value(""), "FILE")
+    ("copy-format",
+     "export SELECT results as raw COPY TO STDOUT data in FORMAT (csv, text or binary), instead of formatting them",
+     cxxopts::value<std::string>()->default_value(""), "FORMAT")
     ;
 
+    AddAgentOptions(options);
+    AddBenchOptions(options);
+    AddReplayOptions(options);
     AddFormatOptions(options);
 }
 
@@ -277,6 +1670,9 @@ DbProxyOptions HandleDbProxyOptions(const cxxopts::ParseResult &parsed_options)
     DbProxyOptions options{handleConnectionOptions(parsed_options),
         HandleFormatOptions(parsed_options)};
 
+    options.agent_options = HandleAgentOptions(parsed_options);
+    options.bench_options = HandleBenchOptions(parsed_options);
+    options.replay_options = HandleReplayOptions(parsed_options);
     options.list_DBs_and_exit = parsed_options["list-dbs"].as<bool>();
 
     if (parsed_options.count("command")) {
@@ -284,6 +1680,17 @@ DbProxyOptions HandleDbProxyOptions(const cxxopts::ParseResult &parsed_options)
     }
 
     options.command_file = parsed_options["command-file"].as<std::string>();
+    options.fetch_count = parsed_options["fetch-count"].as<std::size_t>();
+    options.binary_results = parsed_options["binary-results"].as<bool>();
+    options.copy_format = parsed_options["copy-format"].as<std::string>();
+    options.statement_timeout_ms = parsed_options["statement-timeout"].as<std::size_t>();
+    options.timing = parsed_options["timing"].as<bool>();
+    options.capture_file = parsed_options["capture"].as<std::string>();
+    options.trace_file = parsed_options["trace"].as<std::string>();
+    options.metrics_file = parsed_options["metrics-file"].as<std::string>();
+    options.pipeline = parsed_options["pipeline"].as<bool>();
+    options.batch_size = parsed_options["batch-size"].as<std::size_t>();
+    options.jobs = parsed_options["jobs"].as<std::size_t>();
 
     return options;
 }
@@ -329,6 +1736,34 @@ CreatePsqlxxCommandGroup(const DbProxy &proxy) {
     ({"@conninfo"}, {}, [&proxy](const auto, const auto) {
         return ToCommandResult(proxy.PrintConnectionInfo());
     }, "Display information about current connection")
+    ({"@timing"}, {"[on|off]"}, [&proxy](const auto words, const auto word_count) {
+        return setTiming(proxy, words, word_count);
+    }, "Toggle printing the time of each statement to stderr")
+    ({"@stats"}, {}, [&proxy](const auto, const auto) {
+        proxy.PrintStats();
+        return CommandResult::success;
+    }, "Print the timing statistics of the session to stderr, result sizes while timing is on")
+    ({"@bg"}, {"QUERY", VARIADIC_ARGUMENT}, [&proxy](const auto words, const auto word_count) {
+        return startJob(proxy, words, word_count);
+    }, "Run a query in the background on a connection of its own, printing its job id")
+    ({"@jobs"}, {}, [&proxy](const auto, const auto) {
+        proxy.PrintJobs();
+        return CommandResult::success;
+    }, "List the background jobs which have not been collected")
+    ({"@fg"}, {"[N]"}, [&proxy](const auto words, const auto word_count) {
+        return collectJob(proxy, words, word_count);
+    }, "Wait for background job N, or the latest one, and print its result")
+    ({"@copyout"}, {"FORMAT", VARIADIC_ARGUMENT}, [&proxy](const auto words, const auto word_count) {
+        return copyOut(proxy, words, word_count);
+    }, "Export query results as raw COPY data in csv, text or binary FORMAT")
+    ({"@copyin"}, {"TABLE", "FILE", VARIADIC_ARGUMENT},
+     [&proxy](const auto words, const auto word_count) {
+        return copyIn(proxy, words, word_count);
+    }, "Load a CSV FILE into TABLE, with [--header] and [--jobs N] parallel streams")
+    ({"@dump-table"}, {"TABLE", "DIR", VARIADIC_ARGUMENT},
+     [&proxy](const auto words, const auto word_count) {
+        return dumpTable(proxy, words, word_count);
+    }, "Export TABLE as CSV files in DIR from one snapshot, with [--jobs N] parallel streams")
     ;
 
     return group;
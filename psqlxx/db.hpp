@@ -1,12 +1,28 @@
 #pragma once
 
+#include <chrono>
 #include <fstream>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include <psqlxx/agent.hpp>
+#include <psqlxx/background_jobs.hpp>
+#include <psqlxx/bench.hpp>
 #include <psqlxx/command.hpp>
+#include <psqlxx/connection_pool.hpp>
 #include <psqlxx/formatter.hpp>
+#include <psqlxx/idle_probe.hpp>
+#include <psqlxx/metrics.hpp>
+#include <psqlxx/pq.hpp>
+#include <psqlxx/query_watchdog.hpp>
+#include <psqlxx/replay.hpp>
+#include <psqlxx/session_state.hpp>
+#include <psqlxx/statement_timing.hpp>
+#include <psqlxx/workload_capture.hpp>
 
 
 namespace cxxopts {
@@ -19,6 +35,7 @@ class ParseResult;
 namespace pqxx {
 
 class connection;
+class result;
 
 }
 
@@ -29,6 +46,12 @@ struct ConnectionOptions {
     std::string base_connection_string;
 
     bool prompt_for_password = true;
+
+    // Attempts to reconnect once the connection is lost, 0 to not reconnect
+    std::size_t reconnect_attempts = 5;
+
+    // Seconds of idleness at the prompt between keepalive probes, 0 to not probe
+    std::size_t keepalive_interval_s = 60;
 };
 
 struct DbProxyOptions {
@@ -36,10 +59,46 @@ struct DbProxyOptions {
 
     FormatterOptions format_options;
 
+    BenchOptions bench_options;
+
+    ReplayOptions replay_options;
+
+    AgentOptions agent_options;
+
     std::vector<std::string> commands;
 
     std::string command_file;
 
+    std::size_t fetch_count = 0;
+
+    bool binary_results = false;
+
+    bool pipeline = false;
+
+    // Statements of a script to run in one transaction, 0 or 1 to run each on its own
+    std::size_t batch_size = 0;
+
+    // Connections to run the statements of a script on, in the order of its annotations
+    std::size_t jobs = 1;
+
+    // Cancel statements running longer than this, 0 to let them run
+    std::size_t statement_timeout_ms = 0;
+
+    // Print the timing of each statement to stderr
+    bool timing = false;
+
+    // File to record the statements of the session to, empty to not record them
+    std::string capture_file;
+
+    // File to write a Chrome trace of psqlxx internals to, empty to not trace
+    std::string trace_file;
+
+    // File to write metrics of a -c or -f run to, empty to not write them
+    std::string metrics_file;
+
+    // COPY format to export SELECT results in, empty to format them
+    std::string copy_format;
+
     bool list_DBs_and_exit = false;
 
     DbProxyOptions(ConnectionOptions conn_opts, FormatterOptions format_opts) :
@@ -49,6 +108,23 @@ struct DbProxyOptions {
 };
 
 
+/**
+ * State of the session's transaction block, which the user opens with BEGIN.
+ */
+enum class TransactionStatus {
+    idle,
+    in_transaction,
+    failed,
+};
+
+
+/**
+ * @return  true if sql_cmd begins, ends or otherwise controls a transaction block.
+ */
+[[nodiscard]]
+bool IsTransactionControl(std::string_view sql_cmd);
+
+
 namespace internal {
 
 /**
@@ -57,8 +133,39 @@ namespace internal {
 [[nodiscard]]
 std::string overridePassword(std::string connection_string, std::string password);
 
+/**
+ * @param   connection_string   if not null, receives the connection string that succeeded,
+ *                              including the password entered at the prompt.
+ */
+[[nodiscard]]
+std::unique_ptr<pqxx::connection> makeConnection(const ConnectionOptions &options,
+                                                 std::string *connection_string = nullptr);
+
+/**
+ * @return  The query without trailing semicolons, if it is a single SELECT, VALUES,
+ *          TABLE or WITH statement, which can be fetched through a cursor; otherwise empty,
+ *          as also for SELECT INTO and data-modifying WITH statements.
+ */
+[[nodiscard]]
+std::string_view toCursorQuery(std::string_view sql_cmd);
+
+/**
+ * @return  The delay before the next attempt to reconnect, after attempt has failed,
+ *          which doubles with each attempt, up to a bound.
+ */
 [[nodiscard]]
-std::unique_ptr<pqxx::connection> makeConnection(const ConnectionOptions &options);
+std::chrono::milliseconds getReconnectDelay(const std::size_t attempt);
+
+/**
+ * Splits a table of page_count pages into up to part_count ranges of pages.
+ *
+ * @return  One query per range, selecting the rows whose ctid falls into the range.
+ *          The first and last ranges are open ended.
+ */
+[[nodiscard]]
+std::vector<std::string> buildCtidRangeQueries(const std::string_view table,
+                                               const std::size_t page_count,
+                                               const std::size_t part_count);
 
 }//namespace internal
 
@@ -72,17 +179,97 @@ class DbProxy {
     mutable std::ostream m_out;
 
     TypeMap m_pg_type_map;
-    std::unique_ptr<pqxx::connection> m_connection;
+    // Replaced by reconnect(), under the mutex, if the connection is lost
+    mutable std::unique_ptr<pqxx::connection> m_connection;
+    mutable std::mutex m_connection_mutex;
+
+    // Underneath m_connection, for the libpq features pqxx lacks. Replaced with it.
+    mutable PGconn *m_session_connection = nullptr;
+
+    std::string m_connection_string;
+
+    mutable TransactionStatus m_transaction_status = TransactionStatus::idle;
+
+    // To restore on reconnecting
+    mutable SessionState m_session_state;
+    // Of the transaction block, which take effect only once it is committed
+    mutable std::vector<std::string> m_pending_session_changes;
+
+    std::unique_ptr<WorkloadCapture> m_capture;
+
+    mutable bool m_timing_enabled = false;
+    // Of the statement being executed
+    mutable StatementTiming m_timing;
+    mutable SessionStats m_stats;
+    mutable RunMetrics m_metrics;
+
+    mutable QueryWatchdog m_watchdog;
+    // Of the statement being executed, -1 if unknown
+    mutable std::int64_t m_row_count = -1;
+
+    // Of background statements. Declared before the jobs, which return their connections
+    // to it when they are destroyed.
+    mutable ConnectionPool<pqxx::connection> m_pool;
+    mutable BackgroundJobs<pqxx::result> m_jobs;
+
+    // Declared after the connection, which its probes use.
+    mutable IdleProbe m_idle_probe;
 
     void connect();
     void initTypeMap();
 
+    /**
+     * Replaces the lost connection, retrying with backoff, and restores the session state.
+     * The transaction block of the lost connection, if any, is gone.
+     */
+    bool reconnect() const;
+    /**
+     * Replays the recorded session state on the connection, which has lost it.
+     */
+    void restoreSessionState() const;
+
+    /**
+     * Keeps the idle connection alive, and finds out if it has been lost.
+     */
+    void probe() const;
+    void reconnectIfLost() const;
+
+    /**
+     * Takes the transaction status from the server, which reports it after each statement.
+     */
+    void updateTransactionStatus() const;
+
+    void recordSessionState(const std::string_view sql_cmd,
+                            const TransactionStatus previous_status) const;
+
+    /**
+     * Lets the statement about to run on the session's connection be cancelled by
+     * CancelStatement() or the statement timeout.
+     */
+    [[nodiscard]]
+    QueryWatchdog::Watch watchStatement() const;
+
+    template <typename Result>
+    void printResult(const Result &a_result, const std::string_view title) const;
+
+    [[nodiscard]]
+    bool fetchInBatches(const std::string_view cursor_query) const;
+
+    [[nodiscard]]
+    bool fetchInBinary(const std::string_view query) const;
+
+    [[nodiscard]]
+    bool execute(const std::string_view sql_cmd, const ResultHandler &handler) const;
+
 public:
     explicit DbProxy(DbProxyOptions options);
+    // Waits for the background statements still running.
+    ~DbProxy();
 
     [[nodiscard]]
     operator bool() const {
-        return m_connection and (m_options.format_options.out_file.empty() or m_out_file);
+        return m_connection and (m_options.format_options.out_file.empty() or m_out_file) and
+               (not m_capture or *m_capture);
     }
 
     [[nodiscard]]
@@ -93,15 +280,184 @@ public:
     [[nodiscard]]
     std::string GetDbName() const;
 
+    /**
+     * @return  The connection string that succeeded, for further connections of the session.
+     */
+    [[nodiscard]]
+    const std::string &GetConnectionString() const {
+        return m_connection_string;
+    }
+
+    /**
+     * Probes the connection every --keepalive-interval, until the returned Idle is
+     * destroyed, such as while waiting at the prompt. If a probe found the connection lost,
+     * destroying the Idle reconnects, on the thread which runs the statements.
+     */
+    [[nodiscard]]
+    IdleProbe::Idle KeepAliveWhileIdle() const {
+        return m_idle_probe.Begin([this] {
+            probe();
+        }, [this] {
+            reconnectIfLost();
+        });
+    }
+
+    /**
+     * Sends the output to buffer instead, such as to a client of the agent.
+     *
+     * @return  The buffer the output was sent to.
+     */
+    std::streambuf *SetOutput(std::streambuf *const buffer) const {
+        return m_out.rdbuf(buffer);
+    }
+
+    [[nodiscard]]
+    TransactionStatus GetTransactionStatus() const {
+        return m_transaction_status;
+    }
+
     [[nodiscard]]
     bool PrintConnectionInfo() const;
 
+    /**
+     * Turns printing the timing of each statement to stderr on or off.
+     */
+    void SetTiming(const bool enabled) const {
+        m_timing_enabled = enabled;
+    }
+
+    [[nodiscard]]
+    bool GetTiming() const {
+        return m_timing_enabled;
+    }
+
+    /**
+     * Cancels the statement in flight on the server, keeping the session. Safe to call from
+     * a signal handler.
+     *
+     * @return  false if no statement is in flight.
+     */
+    bool CancelStatement() const noexcept {
+        return m_watchdog.RequestCancel();
+    }
+
+    [[nodiscard]]
+    const RunMetrics &GetMetrics() const {
+        return m_metrics;
+    }
+
+    /**
+     * Prints the timings of the statements run so far to stderr.
+     */
+    void PrintStats() const {
+        m_stats.Print(std::cerr);
+    }
+
     void PrintResult(const pqxx::result &a_result,
                      const std::string_view title = {}) const;
+    void PrintResult(const PqResult &a_result,
+                     const std::string_view title = {}) const;
 
+    /**
+     * Runs sql_cmd in autocommit mode, or in the transaction block the user has begun.
+     * It is recorded to the --capture file, if any, and timed. If the connection is lost,
+     * it is replaced, but sql_cmd is not retried.
+     */
     [[nodiscard]]
     bool DoTransaction(const std::string_view sql_cmd,
                        const ResultHandler handler = {}) const;
+
+    /**
+     * Rolls back the transaction block the user has begun, if any, and discards the
+     * session state, such as settings, prepared statements and temporary tables.
+     */
+    [[nodiscard]]
+    bool ResetSession() const;
+
+    /**
+     * Runs sql_cmd in autocommit mode on a pooled connection of its own, without blocking,
+     * with the session state restored on it. It is neither recorded nor timed, and cannot
+     * see the user's transaction block.
+     *
+     * @return  The result, or the exception thrown if sql_cmd failed.
+     */
+    [[nodiscard]]
+    std::future<pqxx::result> ExecuteAsync(std::string sql_cmd) const;
+
+    /**
+     * Runs sql_cmd through ExecuteAsync() as a background job, and prints its id.
+     */
+    void StartJob(std::string sql_cmd) const;
+
+    /**
+     * Prints the background jobs which have not been collected.
+     */
+    void PrintJobs() const;
+
+    /**
+     * Waits for a background job, and prints its result or error.
+     *
+     * @param   id  of the job, or nullopt for the latest one.
+     */
+    [[nodiscard]]
+    bool CollectJob(const std::optional<std::size_t> id) const;
+
+    /**
+     * Streams the raw COPY TO STDOUT data of query, in csv, text or binary format, to the output.
+     */
+    [[nodiscard]]
+    bool CopyOut(const std::string_view query, const std::string_view format) const;
+
+    /**
+     * Runs statements in one transaction, and prints their results once it is committed.
+     * If it fails, the statements are replayed one by one, so that the failing statement
+     * is reported as it would be without batching; up to the first which fails again, if
+     * stop_at_failure.
+     */
+    [[nodiscard]]
+    bool DoBatch(const std::vector<std::string_view> &statements,
+                 const bool stop_at_failure) const;
+
+    /**
+     * Sends single statements through a libpq pipeline, keeping many of them in flight,
+     * and prints their results in order. Each statement is followed by a sync, so a
+     * failed one is reported and the rest still run.
+     *
+     * @return  true if all statements succeeded.
+     */
+    [[nodiscard]]
+    bool RunPipeline(const std::vector<std::string> &statements) const;
+
+    /**
+     * Runs statements in autocommit mode on up to jobs connections of their own, each as
+     * soon as the statements it depends on have completed, and prints their results in
+     * the order of statements.
+     *
+     * @param   dependencies    for each statement, the earlier statements it depends on.
+     * @return  true if all statements succeeded. The dependents of a failed statement are
+     *          skipped and reported, the others still run.
+     */
+    [[nodiscard]]
+    bool RunInParallel(const std::vector<std::string_view> &statements,
+                       const std::vector<std::vector<std::size_t>> &dependencies,
+                       const std::size_t jobs) const;
+
+    /**
+     * Loads a CSV file into table, split into up to jobs parts which are copied in parallel.
+     *
+     * @note    Each part is committed on its own, so a failed part leaves the others loaded.
+     */
+    [[nodiscard]]
+    bool CopyIn(const std::string_view table, const std::string &file_path,
+                const std::size_t jobs, const bool header) const;
+
+    /**
+     * Exports table as CSV files in directory, one per ctid range, which are copied out
+     * in parallel by up to jobs connections sharing one snapshot.
+     */
+    [[nodiscard]]
+    bool DumpTable(const std::string_view table, const std::string &directory,
+                   const std::size_t jobs) const;
 };
 
 void AddDbProxyOptions(cxxopts::Options &options);
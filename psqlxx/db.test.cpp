@@ -89,3 +89,83 @@ TEST(overridePasswordTests, KeyValueFormWithPasswordShallReturnExpected) {
 
     ASSERT_EQ(EXPECTED, actual);
 }
+
+
+TEST(ToCursorQueryTests, ReturnEmptyIfGivenEmptyCommand) {
+    ASSERT_TRUE(internal::toCursorQuery(" \n").empty());
+}
+
+TEST(ToCursorQueryTests, ReturnStrippedIfGivenSelect) {
+    ASSERT_EQ("SELECT * FROM pg_tables", internal::toCursorQuery(" SELECT * FROM pg_tables ; "));
+}
+
+TEST(ToCursorQueryTests, KeywordIsCaseInsensitive) {
+    ASSERT_EQ("values (1)", internal::toCursorQuery("values (1);"));
+}
+
+TEST(ToCursorQueryTests, ReturnEmptyIfGivenMultipleStatements) {
+    ASSERT_TRUE(internal::toCursorQuery("select 1; select 2;").empty());
+}
+
+TEST(ToCursorQueryTests, ReturnEmptyIfGivenNonSelect) {
+    ASSERT_TRUE(internal::toCursorQuery("selection").empty());
+    ASSERT_TRUE(internal::toCursorQuery("INSERT INTO t VALUES (1)").empty());
+}
+
+TEST(ToCursorQueryTests, ReturnEmptyIfGivenWritingQuery) {
+    ASSERT_TRUE(internal::toCursorQuery(
+                    "WITH d AS (DELETE FROM t RETURNING *) SELECT * FROM d").empty());
+    ASSERT_TRUE(internal::toCursorQuery("select * into new_t from t").empty());
+}
+
+TEST(ToCursorQueryTests, SkipQuotedWords) {
+    ASSERT_EQ("SELECT 'into', \"delete\" -- update\nFROM t",
+              internal::toCursorQuery("SELECT 'into', \"delete\" -- update\nFROM t"));
+    ASSERT_EQ("SELECT /* insert */ 1", internal::toCursorQuery("SELECT /* insert */ 1"));
+}
+
+TEST(BuildCtidRangeQueriesTests, ReturnWholeTableIfGivenOnePart) {
+    const std::vector<std::string> expected{"SELECT * FROM t"};
+    ASSERT_EQ(expected, internal::buildCtidRangeQueries("t", 100, 1));
+}
+
+TEST(BuildCtidRangeQueriesTests, ReturnWholeTableIfGivenEmptyTable) {
+    const std::vector<std::string> expected{"SELECT * FROM t"};
+    ASSERT_EQ(expected, internal::buildCtidRangeQueries("t", 0, 4));
+}
+
+TEST(BuildCtidRangeQueriesTests, CanSplitPagesIntoOpenEndedRanges) {
+    const std::vector<std::string> expected{
+        "SELECT * FROM t WHERE ctid < '(3,0)'::tid",
+        "SELECT * FROM t WHERE ctid >= '(3,0)'::tid AND ctid < '(6,0)'::tid",
+        "SELECT * FROM t WHERE ctid >= '(6,0)'::tid",
+    };
+    ASSERT_EQ(expected, internal::buildCtidRangeQueries("t", 10, 3));
+}
+
+TEST(BuildCtidRangeQueriesTests, ReturnNoMoreRangesThanPages) {
+    ASSERT_EQ(2u, internal::buildCtidRangeQueries("t", 2, 8).size());
+}
+
+TEST(GetReconnectDelayTests, CanDoubleDelayUpToBound) {
+    using namespace std::chrono_literals;
+    ASSERT_EQ(100ms, internal::getReconnectDelay(0));
+    ASSERT_EQ(200ms, internal::getReconnectDelay(1));
+    ASSERT_EQ(400ms, internal::getReconnectDelay(2));
+    ASSERT_EQ(5000ms, internal::getReconnectDelay(6));
+    ASSERT_EQ(5000ms, internal::getReconnectDelay(100));
+}
+
+TEST(IsTransactionControlTests, ReturnTrueIfGivenTransactionControl) {
+    for (const auto sql : {"BEGIN", "start transaction", "commit;", "END", "rollback to s",
+                           "abort", "SAVEPOINT s", "release s", "prepare transaction 'x'"}) {
+        ASSERT_TRUE(IsTransactionControl(sql)) << sql;
+    }
+}
+
+TEST(IsTransactionControlTests, ReturnFalseIfGivenOtherStatements) {
+    for (const auto sql : {"", "select 1", "insert into t values (1)", "prepare q as select 1",
+                           "beginning"}) {
+        ASSERT_FALSE(IsTransactionControl(sql)) << sql;
+    }
+}
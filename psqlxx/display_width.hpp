@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string_view>
+
+
+namespace psqlxx {
+
+/**
+ * @return  The number of terminal columns text takes, assuming it is UTF-8 encoded.
+ *
+ * @note    East Asian Wide and Fullwidth characters take 2 columns; combining
+ *          characters and other zero width characters take none. Each invalid byte
+ *          takes 1 column.
+ */
+[[nodiscard]]
+std::size_t GetDisplayWidth(const std::string_view text);
+
+
+namespace internal {
+
+[[nodiscard]]
+bool isAscii(const std::string_view text);
+
+[[nodiscard]]
+int getCodePointWidth(const char32_t code_point);
+
+}//namespace internal
+
+}//namespace psqlxx
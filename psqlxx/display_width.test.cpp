@@ -0,0 +1,49 @@
+#include <psqlxx/display_width.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(IsAsciiTests, ReturnTrueIfGivenEmptyText) {
+    ASSERT_TRUE(internal::isAscii(""));
+}
+
+TEST(IsAsciiTests, DetectNonAsciiAtEveryPosition) {
+    for (std::size_t size = 1; size < 80; ++size) {
+        for (std::size_t position = 0; position < size; ++position) {
+            std::string text(size, 'a');
+            ASSERT_TRUE(internal::isAscii(text));
+            text[position] = '\xC3';
+            ASSERT_FALSE(internal::isAscii(text));
+        }
+    }
+}
+
+TEST(GetDisplayWidthTests, AsciiWidthIsSize) {
+    ASSERT_EQ(0u, GetDisplayWidth(""));
+    ASSERT_EQ(11u, GetDisplayWidth("hello world"));
+}
+
+TEST(GetDisplayWidthTests, LatinLettersTakeOneColumn) {
+    ASSERT_EQ(5u, GetDisplayWidth("na\xC3\xAFve"));
+}
+
+TEST(GetDisplayWidthTests, WideCharactersTakeTwoColumns) {
+    ASSERT_EQ(6u, GetDisplayWidth("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E"));
+    ASSERT_EQ(2u, GetDisplayWidth("\xF0\x9F\x98\x80"));
+    ASSERT_EQ(2u, GetDisplayWidth("\xEF\xBC\xA1"));
+}
+
+TEST(GetDisplayWidthTests, CombiningCharactersTakeNoColumn) {
+    ASSERT_EQ(1u, GetDisplayWidth("e\xCC\x81"));
+    ASSERT_EQ(0u, GetDisplayWidth("\xE2\x80\x8B"));
+}
+
+TEST(GetDisplayWidthTests, InvalidBytesTakeOneColumnEach) {
+    ASSERT_EQ(2u, GetDisplayWidth("\xFF\xFE"));
+    ASSERT_EQ(3u, GetDisplayWidth("a\xE6\x97"));
+}
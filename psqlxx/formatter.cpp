@@ -1,92 +1,112 @@
 #include <psqlxx/formatter.hpp>
 
+#include <algorithm>
+#include <thread>
+#include <utility>
+
 #include <cxxopts.hpp>
 #include <pqxx/pqxx>
 
+#include <psqlxx/csv.hpp>
+#include <psqlxx/display_width.hpp>
+#include <psqlxx/output_buffer.hpp>
+#include <psqlxx/pq.hpp>
+#include <psqlxx/trace.hpp>
 
-namespace {
 
-struct ColumnInfo {
-    std::size_t width = 0;
-    bool is_numeric = false;
-};
+using namespace psqlxx;
+using psqlxx::internal::ColumnInfo;
+
 
-inline auto &printSummary(std::ostream &out, const std::size_t size) {
-    out << "(" << size << " row";
+namespace {
+
+inline auto &printSummary(OutputBuffer &out, const std::size_t size) {
+    out.Append("(").Append(size).Append(" row");
     if (size > 1) {
-        out << 's';
+        out.Append('s');
     }
-    return out << ")";
+    return out.Append(')');
 }
 
-auto &printStrInCenter(std::ostream &out, const std::string_view a_field,
+[[nodiscard]]
+inline int getPadding(const std::string_view a_field, const int width) {
+    // Unaligned output has no width to pad to, so skip measuring the field.
+    if (width <= 0) {
+        return width;
+    }
+    return width - static_cast<int>(GetDisplayWidth(a_field));
+}
+
+auto &printStrInCenter(OutputBuffer &out, const std::string_view a_field,
                        const int width) {
-    const int padding = width - a_field.size();
-    const auto half_spaces = std::string(padding > 1 ? padding / 2 : 0, ' ');
-    out << half_spaces << a_field << half_spaces;
+    const auto padding = getPadding(a_field, width);
+    const std::size_t half_spaces = padding > 1 ? padding / 2 : 0;
+    out.AppendFill(' ', half_spaces).Append(a_field).AppendFill(' ', half_spaces);
     if (padding > 0 and padding % 2 != 0) {
-        out << ' ';
+        out.Append(' ');
     }
 
     return out;
 }
 
-auto &printStrLeft(std::ostream &out, const std::string_view a_field,
+auto &printStrLeft(OutputBuffer &out, const std::string_view a_field,
                    const int width) {
-    const int padding = width - a_field.size() - 1;
-    const auto spaces = std::string(padding > 0 ? padding : 0, ' ');
+    const auto padding = getPadding(a_field, width) - 1;
     if (padding > 0) {
-        out << ' ';
+        out.Append(' ');
     }
-    return out << a_field << spaces;
+    return out.Append(a_field).AppendFill(' ', padding > 0 ? padding : 0);
 }
 
-auto &printStrRight(std::ostream &out, const std::string_view a_field,
+auto &printStrRight(OutputBuffer &out, const std::string_view a_field,
                     const int width) {
-    const int padding = width - a_field.size() - 1;
-    const auto spaces = std::string(padding > 0 ? padding : 0, ' ');
-    out << spaces << a_field;
+    const auto padding = getPadding(a_field, width) - 1;
+    out.AppendFill(' ', padding > 0 ? padding : 0).Append(a_field);
     if (padding > 0) {
-        out << ' ';
+        out.Append(' ');
     }
 
     return out;
 }
 
-void printHeaders(std::ostream &out, const pqxx::result &a_result,
-                  const std::vector<ColumnInfo> &column_infos, const std::string_view delimiter) {
+auto &printHeader(OutputBuffer &out, const std::string_view name,
+                  const psqlxx::FormatterOptions &options, const ColumnInfo &column_info) {
+    if (options.csv) {
+        AppendCsvField(out, name, options.delimiter.front());
+        return out;
+    }
+
+    return printStrInCenter(out, name, column_info.width);
+}
+
+template <typename Result>
+void printHeaders(OutputBuffer &out, const Result &a_result,
+                  const std::vector<ColumnInfo> &column_infos,
+                  const psqlxx::FormatterOptions &options) {
     for (std::size_t i = 0; i < column_infos.size() - 1; ++i) {
-        printStrInCenter(out, a_result.column_name(i),
-                         column_infos[i].width) << delimiter;
+        printHeader(out, a_result.column_name(i), options,
+                    column_infos[i]).Append(options.delimiter);
     }
-    printStrInCenter(out, a_result.column_name(a_result.columns() - 1),
-                     column_infos.back().width) << '\n';
+    printHeader(out, a_result.column_name(a_result.columns() - 1), options,
+                column_infos.back()).Append('\n');
 }
 
-auto &printField(std::ostream &out, const std::string_view a_field,
-                 const std::string_view special_chars, const ColumnInfo &column_info) {
-    const auto do_quote = (not special_chars.empty()) and
-                          (a_field.find_first_of(special_chars) != std::string_view::npos);
-    if (do_quote) {
-        out << '"';
+auto &printField(OutputBuffer &out, const std::string_view a_field,
+                 const psqlxx::FormatterOptions &options, const ColumnInfo &column_info) {
+    if (options.csv) {
+        AppendCsvField(out, a_field, options.delimiter.front());
+        return out;
     }
 
     if (column_info.is_numeric) {
-        printStrRight(out, a_field, column_info.width);
+        return printStrRight(out, a_field, column_info.width);
     } else {
-        printStrLeft(out, a_field, column_info.width);
+        return printStrLeft(out, a_field, column_info.width);
     }
-
-    if (do_quote) {
-        out << '"';
-    }
-
-    return out;
 }
 
-inline auto &printFieldBar(std::ostream &out, const int width) {
-    std::string bar(width, '-');
-    return out << bar;
+inline auto &printFieldBar(OutputBuffer &out, const std::size_t width) {
+    return out.AppendFill('-', width);
 }
 
 [[nodiscard]]
@@ -103,9 +123,60 @@ auto isNumeric(const psqlxx::TypeMap &type_map, const pqxx::oid oid) {
     return false;
 }
 
+/**
+ * Rows that one job formats at a time. Results with fewer rows are formatted on one thread.
+ */
+constexpr std::size_t ROWS_PER_JOB = 8192;
+
+[[nodiscard]]
+std::size_t getMaxJobCount(const std::size_t requested_jobs) {
+    const std::size_t jobs = requested_jobs ? requested_jobs :
+                             std::thread::hardware_concurrency();
+    return std::max<std::size_t>(jobs, 1);
+}
+
 [[nodiscard]]
-auto getColumnInfos(const pqxx::result &a_result, const psqlxx::TypeMap &type_map,
-                    const bool no_align) {
+std::size_t getJobCount(const std::size_t requested_jobs, const std::size_t row_count) {
+    return std::clamp<std::size_t>(row_count / ROWS_PER_JOB, 1, getMaxJobCount(requested_jobs));
+}
+
+/**
+ * Splits rows [begin, end) into jobs consecutive ranges,
+ * and calls fn(job_index, first_row, last_row) for each range on the workers.
+ */
+template <typename Function>
+void forEachRowRange(WorkerPool *const workers, const std::size_t begin, const std::size_t end,
+                     const std::size_t jobs, const Function &fn) {
+    if (jobs <= 1 or not workers) {
+        fn(0, begin, end);
+        return;
+    }
+
+    const auto range_size = (end - begin + jobs - 1) / jobs;
+    workers->Run(jobs, [begin, end, range_size, &fn](const std::size_t i) {
+        const auto first = std::min(end, begin + i * range_size);
+        fn(i, first, std::min(end, first + range_size));
+    });
+}
+
+template <typename Result>
+void updateColumnWidths(std::vector<std::size_t> &widths, const Result &a_result,
+                        const std::size_t first_row, const std::size_t last_row) {
+    const TraceSpan span{"scanWidths"};
+    for (auto i = first_row; i < last_row; ++i) {
+        const auto row = a_result[i];
+        if (not row.empty()) {
+            for (std::size_t j = 0; j < widths.size(); ++j) {
+                widths[j] = std::max(widths[j], GetDisplayWidth(row[j].view()));
+            }
+        }
+    }
+}
+
+template <typename Result>
+[[nodiscard]]
+auto getColumnInfos(const Result &a_result, const psqlxx::TypeMap &type_map,
+                    const bool no_align, WorkerPool *const workers, const std::size_t jobs) {
     std::vector<ColumnInfo> column_infos(a_result.columns());
 
     for (std::size_t i = 0; i < column_infos.size(); ++i) {
@@ -116,15 +187,20 @@ auto getColumnInfos(const pqxx::result &a_result, const psqlxx::TypeMap &type_ma
         return column_infos;
     }
 
+    std::vector<std::size_t> header_widths(column_infos.size());
     for (std::size_t i = 0; i < column_infos.size(); ++i) {
-        column_infos[i].width = std::strlen(a_result.column_name(i));
+        header_widths[i] = GetDisplayWidth(a_result.column_name(i));
     }
 
-    for (const auto &row : a_result) {
-        if (not row.empty()) {
-            for (std::size_t i = 0; i < column_infos.size(); ++i) {
-                column_infos[i].width = std::max(column_infos[i].width, row[i].view().size());
-            }
+    std::vector<std::vector<std::size_t>> range_widths(jobs, header_widths);
+    forEachRowRange(workers, 0, a_result.size(), jobs,
+    [&a_result, &range_widths](const auto job, const auto first_row, const auto last_row) {
+        updateColumnWidths(range_widths[job], a_result, first_row, last_row);
+    });
+
+    for (const auto &widths : range_widths) {
+        for (std::size_t i = 0; i < column_infos.size(); ++i) {
+            column_infos[i].width = std::max(column_infos[i].width, widths[i]);
         }
     }
 
@@ -135,6 +211,23 @@ auto getColumnInfos(const pqxx::result &a_result, const psqlxx::TypeMap &type_ma
     return column_infos;
 }
 
+template <typename Result>
+void printRowRange(OutputBuffer &out, const Result &a_result,
+                   const std::size_t first_row, const std::size_t last_row,
+                   const std::vector<ColumnInfo> &column_infos,
+                   const psqlxx::FormatterOptions &options) {
+    const TraceSpan span{"formatRows"};
+    for (auto i = first_row; i < last_row; ++i) {
+        const auto row = a_result[i];
+        if (not row.empty()) {
+            for (std::size_t j = 0; j < column_infos.size() - 1; ++j) {
+                printField(out, row[j].view(), options, column_infos[j]).Append(options.delimiter);
+            }
+            printField(out, row.back().view(), options, column_infos.back()).Append('\n');
+        }
+    }
+}
+
 }
 
 
@@ -149,6 +242,10 @@ void AddFormatOptions(cxxopts::Options &options) {
 
     ("F,field-separator", "field separator for unaligned output",
      cxxopts::value<std::string>()->default_value("|"))
+    ("realign-batches", "with --fetch-count, recompute aligned column widths for each batch",
+     cxxopts::value<bool>()->default_value("false"))
+    ("format-jobs", "number of threads to format large results with, 0 to use all cores",
+     cxxopts::value<std::size_t>()->default_value("0"), "N")
 
     ("o,out-file", "send query results to file",
      cxxopts::value<std::string>()->default_value(""))
@@ -161,8 +258,8 @@ FormatterOptions HandleFormatOptions(const cxxopts::ParseResult &parsed_options)
     options.out_file = parsed_options["out-file"].as<std::string>();
 
     if (parsed_options["csv"].as<bool>()) {
+        options.csv = true;
         options.delimiter = ",";
-        options.special_chars = options.delimiter + "\n\r";
         options.show_title_and_summary = false;
         options.no_align = true;
     } else {
@@ -170,49 +267,135 @@ FormatterOptions HandleFormatOptions(const cxxopts::ParseResult &parsed_options)
         options.no_align = parsed_options["no-align"].as<bool>();
     }
 
+    options.realign_each_batch = parsed_options["realign-batches"].as<bool>();
+    options.jobs = parsed_options["format-jobs"].as<std::size_t>();
+
     return options;
 }
 
 void PrintResult(const pqxx::result &a_result, const FormatterOptions &options,
                  const TypeMap &type_map, std::ostream &out, const std::string_view title) {
-    if (a_result.columns() > 0) {
-        const auto column_infos = getColumnInfos(a_result, type_map, options.no_align);
-
-        if (options.show_title_and_summary and (not title.empty())) {
-            const auto total_width = std::accumulate(column_infos.cbegin(), column_infos.cend(), 0,
-            [](const auto init, const auto & info) {
-                return init + info.width;
-            });
-            printStrInCenter(out, title, total_width) << '\n';
-        }
+    ResultPrinter printer{options, type_map, out, title};
+    printer.Print(a_result);
+    printer.Finish();
+}
 
-        printHeaders(out, a_result, column_infos, options.delimiter);
+void PrintResult(const PqResult &a_result, const FormatterOptions &options,
+                 const TypeMap &type_map, std::ostream &out, const std::string_view title) {
+    ResultPrinter printer{options, type_map, out, title};
+    printer.Print(a_result);
+    printer.Finish();
+}
 
-        if (not options.no_align) {
-            for (std::size_t i = 0; i < column_infos.size() - 1; ++i) {
-                printFieldBar(out, column_infos[i].width) << '+';
-            }
-            printFieldBar(out, column_infos.back().width) << '\n';
+
+ResultPrinter::ResultPrinter(const FormatterOptions &options, const TypeMap &type_map,
+                             std::ostream &out, const std::string_view title):
+    m_options(options), m_type_map(type_map), m_buffer(out), m_title(title) {
+}
+
+ResultPrinter::ResultPrinter(const FormatterOptions &options, const TypeMap &type_map,
+                             OutputBuffer::BlockWriter writer, const std::string_view title):
+    m_options(options), m_type_map(type_map), m_buffer(std::move(writer)), m_title(title) {
+}
+
+template <typename Result>
+void ResultPrinter::printTableHead(const Result &a_batch) {
+    if (m_options.show_title_and_summary and (not m_title.empty())) {
+        const auto total_width = std::accumulate(m_column_infos.cbegin(), m_column_infos.cend(), 0,
+        [](const auto init, const auto & info) {
+            return init + info.width;
+        });
+        printStrInCenter(m_buffer, m_title, total_width).Append('\n');
+    }
+
+    printHeaders(m_buffer, a_batch, m_column_infos, m_options);
+
+    if (not m_options.no_align) {
+        for (std::size_t i = 0; i < m_column_infos.size() - 1; ++i) {
+            printFieldBar(m_buffer, m_column_infos[i].width).Append('+');
         }
+        printFieldBar(m_buffer, m_column_infos.back().width).Append('\n');
+    }
+}
 
-        for (const auto &row : a_result) {
-            if (not row.empty()) {
-                for (std::size_t i = 0; i < column_infos.size() - 1; ++i) {
-                    printField(out, row[i].view(), options.special_chars,
-                               column_infos[i]) << options.delimiter;
-                }
-                printField(out, row.back().view(), options.special_chars,
-                           column_infos.back()) << '\n';
+template <typename Result>
+void ResultPrinter::printRows(const Result &a_batch, const std::size_t jobs) {
+    const std::size_t row_count = a_batch.size();
+    if (jobs <= 1) {
+        printRowRange(m_buffer, a_batch, 0, row_count, m_column_infos, m_options);
+        return;
+    }
+
+    // Each job formats its own range into its own blocks, which are then written in order.
+    std::vector<std::vector<std::string>> range_blocks(jobs);
+    for (std::size_t begin = 0; begin < row_count; begin += jobs * ROWS_PER_JOB) {
+        const auto end = std::min(row_count, begin + jobs * ROWS_PER_JOB);
+        forEachRowRange(m_workers.get(), begin, end, jobs,
+        [this, &a_batch, &range_blocks](const auto job, const auto first_row, const auto last_row) {
+            auto &blocks = range_blocks[job];
+            OutputBuffer range_buffer{[&blocks](std::string & block) {
+                blocks.push_back(std::exchange(block, std::string{}));
+            }};
+            printRowRange(range_buffer, a_batch, first_row, last_row, m_column_infos, m_options);
+        });
+
+        for (auto &blocks : range_blocks) {
+            for (auto &a_block : blocks) {
+                m_buffer.WriteBlock(a_block);
             }
+            blocks.clear();
         }
+    }
+}
 
-        if (options.show_title_and_summary) {
-            printSummary(out, a_result.size()) << std::endl;
-        }
-        if (not options.no_align) {
-            out << std::endl;
-        }
+template <typename Result>
+void ResultPrinter::printBatch(const Result &a_batch) {
+    if (a_batch.columns() == 0) {
+        return;
+    }
+
+    const auto jobs = getJobCount(m_options.jobs, a_batch.size());
+    if (jobs > 1 and not m_workers) {
+        // The calling thread runs jobs too.
+        m_workers = std::make_unique<WorkerPool>(getMaxJobCount(m_options.jobs) - 1);
+    }
+
+    if (m_column_infos.empty()) {
+        m_column_infos = getColumnInfos(a_batch, m_type_map, m_options.no_align, m_workers.get(),
+                                        jobs);
+        printTableHead(a_batch);
+    } else if (m_options.realign_each_batch and not m_options.no_align) {
+        m_column_infos = getColumnInfos(a_batch, m_type_map, m_options.no_align, m_workers.get(),
+                                        jobs);
+    }
+
+    printRows(a_batch, jobs);
+
+    m_row_count += a_batch.size();
+    m_buffer.Flush();
+}
+
+void ResultPrinter::Print(const pqxx::result &a_batch) {
+    printBatch(a_batch);
+}
+
+void ResultPrinter::Print(const PqResult &a_batch) {
+    printBatch(a_batch);
+}
+
+void ResultPrinter::Finish() {
+    if (m_column_infos.empty()) {
+        return;
+    }
+
+    if (m_options.show_title_and_summary) {
+        printSummary(m_buffer, m_row_count).Append('\n');
     }
+    if (not m_options.no_align) {
+        m_buffer.Append('\n');
+    }
+
+    m_buffer.Flush();
 }
 
 }//namespace psqlxx
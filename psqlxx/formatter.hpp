@@ -1,7 +1,13 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
+
+#include <psqlxx/output_buffer.hpp>
+#include <psqlxx/worker_pool.hpp>
 
 
 namespace cxxopts {
@@ -20,16 +26,22 @@ class result;
 
 namespace psqlxx {
 
+class PqResult;
+
 using TypeMap = std::unordered_map<int, std::string>;
 
 struct FormatterOptions {
     std::string out_file;
 
     std::string delimiter;
-    std::string special_chars;
 
+    bool csv = false;
     bool show_title_and_summary = true;
     bool no_align = false;
+    bool realign_each_batch = false;
+
+    // 0 to use all hardware threads
+    std::size_t jobs = 0;
 };
 
 void AddFormatOptions(cxxopts::Options &options);
@@ -42,4 +54,54 @@ void PrintResult(const pqxx::result &a_result, const FormatterOptions &options,
                  const TypeMap &type_map, std::ostream &out,
                  const std::string_view title);
 
+void PrintResult(const PqResult &a_result, const FormatterOptions &options,
+                 const TypeMap &type_map, std::ostream &out,
+                 const std::string_view title);
+
+
+namespace internal {
+
+struct ColumnInfo {
+    std::size_t width = 0;
+    bool is_numeric = false;
+};
+
+}//namespace internal
+
+/**
+ * Prints one result which may arrive in several batches, e.g. fetched from a cursor.
+ *
+ * @note    In aligned mode, column widths come from the first batch, unless
+ *          FormatterOptions::realign_each_batch is set.
+ */
+class ResultPrinter {
+    const FormatterOptions &m_options;
+    const TypeMap &m_type_map;
+    OutputBuffer m_buffer;
+    std::string_view m_title;
+
+    std::vector<internal::ColumnInfo> m_column_infos;
+    std::size_t m_row_count = 0;
+
+    // Started on the first batch large enough to format in parallel, then reused
+    std::unique_ptr<WorkerPool> m_workers;
+
+    template <typename Result>
+    void printTableHead(const Result &a_batch);
+    template <typename Result>
+    void printRows(const Result &a_batch, const std::size_t jobs);
+    template <typename Result>
+    void printBatch(const Result &a_batch);
+
+public:
+    ResultPrinter(const FormatterOptions &options, const TypeMap &type_map,
+                  std::ostream &out, const std::string_view title = {});
+    ResultPrinter(const FormatterOptions &options, const TypeMap &type_map,
+                  OutputBuffer::BlockWriter writer, const std::string_view title = {});
+
+    void Print(const pqxx::result &a_batch);
+    void Print(const PqResult &a_batch);
+    void Finish();
+};
+
 }//namespace psqlxx
@@ -0,0 +1,80 @@
+#include <psqlxx/formatter.hpp>
+#include <psqlxx/pq.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+const TypeMap TYPE_MAP{{23, "int4"}, {25, "text"}};
+
+/**
+ * @return  A result of row_count rows of an int4 and a text column, with varying widths.
+ */
+[[nodiscard]]
+PqResult makeResult(const int row_count) {
+    pq::ResultPtr a_result{PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK)};
+    char id_name[] = "id";
+    char text_name[] = "name";
+    PGresAttDesc columns[] = {{id_name, 0, 0, 0, 23, 4, -1}, {text_name, 0, 0, 0, 25, -1, -1}};
+    EXPECT_EQ(1, PQsetResultAttrs(a_result.get(), 2, columns));
+
+    for (int i = 0; i < row_count; ++i) {
+        auto id = std::to_string(i);
+        auto text = std::string(i % 37, 'x') + (i % 5 == 0 ? "ü, \"q\"" : "");
+        EXPECT_EQ(1, PQsetvalue(a_result.get(), i, 0, id.data(), id.size()));
+        EXPECT_EQ(1, PQsetvalue(a_result.get(), i, 1, text.data(), text.size()));
+    }
+
+    return PqResult{std::move(a_result), TYPE_MAP};
+}
+
+/**
+ * @return  The output of printing a_result twice, as two batches of one result.
+ */
+[[nodiscard]]
+std::string printTwice(const PqResult &a_result, const FormatterOptions &options) {
+    std::stringstream out;
+    ResultPrinter printer{options, TYPE_MAP, out, "title"};
+    printer.Print(a_result);
+    printer.Print(a_result);
+    printer.Finish();
+    return out.str();
+}
+
+}
+
+
+TEST(ResultPrinterTests, CanFormatAlignedInParallel) {
+    const auto a_result = makeResult(40000);
+    FormatterOptions options;
+    options.delimiter = "|";
+    options.realign_each_batch = true;
+
+    options.jobs = 1;
+    const auto expected = printTwice(a_result, options);
+    options.jobs = 4;
+
+    ASSERT_EQ(expected, printTwice(a_result, options));
+}
+
+TEST(ResultPrinterTests, CanFormatCsvInParallel) {
+    const auto a_result = makeResult(40000);
+    FormatterOptions options;
+    options.csv = true;
+    options.delimiter = ",";
+    options.show_title_and_summary = false;
+    options.no_align = true;
+
+    options.jobs = 1;
+    const auto expected = printTwice(a_result, options);
+    options.jobs = 3;
+
+    ASSERT_EQ(expected, printTwice(a_result, options));
+}
@@ -0,0 +1,63 @@
+#include <psqlxx/idle_probe.hpp>
+
+
+namespace psqlxx {
+
+IdleProbe::~IdleProbe() {
+    if (m_thread.joinable()) {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_stopping = true;
+        }
+        m_changed.notify_one();
+        m_thread.join();
+    }
+}
+
+void IdleProbe::end() {
+    // Waits for a probe in progress, which holds the lock.
+    {
+        const std::lock_guard lock{m_mutex};
+        m_probe = {};
+        ++m_generation;
+    }
+    m_changed.notify_one();
+}
+
+IdleProbe::Idle IdleProbe::Begin(ProbeFunction probe, ProbeFunction on_end) {
+    if (m_interval > m_interval.zero()) {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_probe = std::move(probe);
+            ++m_generation;
+        }
+        if (not m_thread.joinable()) {
+            m_thread = std::thread{[this] {
+                run();
+            }};
+        }
+        m_changed.notify_one();
+    }
+
+    return Idle{*this, std::move(on_end)};
+}
+
+void IdleProbe::run() {
+    std::unique_lock lock{m_mutex};
+    while (not m_stopping) {
+        if (not m_probe) {
+            m_changed.wait(lock);
+            continue;
+        }
+
+        const auto generation = m_generation;
+        const auto interrupted = m_changed.wait_for(lock, m_interval, [this, generation] {
+            return m_stopping or m_generation != generation;
+        });
+        if (not interrupted) {
+            m_probe();
+        }
+    }
+}
+
+}//namespace psqlxx
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+
+namespace psqlxx {
+
+/**
+ * Calls a probe from a thread of its own, every interval while the session is idle, such as
+ * to keep its connection alive, or to find out early that it has been lost.
+ */
+class IdleProbe {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ProbeFunction = std::function<void()>;
+
+    /**
+     * Keeps the session idle until it is destroyed, which waits for a probe in progress,
+     * then calls on_end.
+     */
+    class Idle {
+        IdleProbe &m_probe;
+        ProbeFunction m_on_end;
+
+    public:
+        Idle(IdleProbe &probe, ProbeFunction on_end):
+            m_probe(probe), m_on_end(std::move(on_end)) {
+        }
+        Idle(const Idle &) = delete;
+        Idle &operator=(const Idle &) = delete;
+
+        ~Idle() {
+            m_probe.end();
+            if (m_on_end) {
+                m_on_end();
+            }
+        }
+    };
+
+private:
+    const Clock::duration m_interval;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    // Empty while the session is busy
+    ProbeFunction m_probe;
+    // Counts the changes between idle and busy, each of which restarts the interval.
+    std::size_t m_generation = 0;
+    bool m_stopping = false;
+
+    // Started by the first Begin(), if there is an interval
+    std::thread m_thread;
+
+    void end();
+    void run();
+
+public:
+    /**
+     * @param   interval    zero to never probe.
+     */
+    explicit IdleProbe(const Clock::duration interval): m_interval(interval) {
+    }
+    IdleProbe(const IdleProbe &) = delete;
+    IdleProbe &operator=(const IdleProbe &) = delete;
+    ~IdleProbe();
+
+    /**
+     * @param   probe   called on the probe thread, while the Idle lives.
+     * @param   on_end  called on the thread which destroys the Idle, such as to act on what
+     *                  the probes found, without racing the rest of that thread's work.
+     */
+    [[nodiscard]]
+    Idle Begin(ProbeFunction probe, ProbeFunction on_end = {});
+};
+
+}//namespace psqlxx
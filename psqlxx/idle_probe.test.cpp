@@ -0,0 +1,100 @@
+#include <psqlxx/idle_probe.hpp>
+
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace std::chrono_literals;
+
+
+TEST(IdleProbeTests, CanProbeRepeatedlyWhileIdle) {
+    IdleProbe idle_probe{10ms};
+    std::atomic<int> probe_count{0};
+    {
+        const auto idle = idle_probe.Begin([&probe_count] {
+            ++probe_count;
+        });
+        std::this_thread::sleep_for(200ms);
+    }
+
+    ASSERT_GE(probe_count.load(), 2);
+}
+
+TEST(IdleProbeTests, DoNotProbeOnceBusy) {
+    IdleProbe idle_probe{10ms};
+    std::atomic<int> probe_count{0};
+    {
+        const auto idle = idle_probe.Begin([&probe_count] {
+            ++probe_count;
+        });
+    }
+    const auto count_when_busy = probe_count.load();
+    std::this_thread::sleep_for(100ms);
+
+    ASSERT_EQ(count_when_busy, probe_count.load());
+}
+
+TEST(IdleProbeTests, DoNotProbeBeforeInterval) {
+    IdleProbe idle_probe{10s};
+    std::atomic<int> probe_count{0};
+    {
+        const auto idle = idle_probe.Begin([&probe_count] {
+            ++probe_count;
+        });
+        std::this_thread::sleep_for(50ms);
+    }
+
+    ASSERT_EQ(0, probe_count.load());
+}
+
+TEST(IdleProbeTests, DoNotProbeWithoutInterval) {
+    IdleProbe idle_probe{0s};
+    std::atomic<int> probe_count{0};
+    {
+        const auto idle = idle_probe.Begin([&probe_count] {
+            ++probe_count;
+        });
+        std::this_thread::sleep_for(50ms);
+    }
+
+    ASSERT_EQ(0, probe_count.load());
+}
+
+TEST(IdleProbeTests, EndWaitsForProbeInProgress) {
+    IdleProbe idle_probe{1ms};
+    std::atomic<bool> probing{false};
+    std::atomic<bool> overlapped{false};
+    for (int i = 0; i < 20; ++i) {
+        {
+            const auto idle = idle_probe.Begin([&probing] {
+                probing = true;
+                std::this_thread::sleep_for(5ms);
+                probing = false;
+            });
+            std::this_thread::sleep_for(3ms);
+        }
+        overlapped = overlapped or probing;
+    }
+
+    ASSERT_FALSE(overlapped.load());
+}
+
+TEST(IdleProbeTests, CallOnEndAfterLastProbe) {
+    IdleProbe idle_probe{1ms};
+    std::atomic<bool> probing{false};
+    std::atomic<bool> ended_while_probing{true};
+    {
+        const auto idle = idle_probe.Begin([&probing] {
+            probing = true;
+            std::this_thread::sleep_for(5ms);
+            probing = false;
+        }, [&probing, &ended_while_probing] {
+            ended_while_probing = probing.load();
+        });
+        std::this_thread::sleep_for(3ms);
+    }
+
+    ASSERT_FALSE(ended_while_probing.load());
+}
@@ -0,0 +1,102 @@
+#include <psqlxx/latency_histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using ValueType = LatencyHistogram::ValueType;
+
+constexpr auto SUB_BUCKET_BITS = LatencyHistogram::SUB_BUCKET_BITS;
+constexpr auto SUB_BUCKET_COUNT = LatencyHistogram::SUB_BUCKET_COUNT;
+
+// Values below twice the sub-bucket count are recorded exactly.
+constexpr auto LINEAR_COUNT = 2 * SUB_BUCKET_COUNT;
+
+/**
+ * @return  The count of low bits a value loses in its bucket.
+ */
+[[nodiscard]]
+inline unsigned getMagnitude(const ValueType value) {
+    if (value < LINEAR_COUNT) {
+        return 0;
+    }
+    const unsigned bit_width = 64 - __builtin_clzll(value);
+    return bit_width - (SUB_BUCKET_BITS + 1);
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::size_t getHistogramIndex(const ValueType value) {
+    const auto magnitude = getMagnitude(value);
+    if (magnitude == 0) {
+        return value;
+    }
+    return LINEAR_COUNT + (magnitude - 1) * SUB_BUCKET_COUNT +
+           ((value >> magnitude) - SUB_BUCKET_COUNT);
+}
+
+ValueType getHighestEquivalentValue(const std::size_t index) {
+    if (index < LINEAR_COUNT) {
+        return index;
+    }
+    const auto magnitude = (index - LINEAR_COUNT) / SUB_BUCKET_COUNT + 1;
+    const auto sub_bucket = (index - LINEAR_COUNT) % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+}//namespace internal
+
+
+LatencyHistogram::LatencyHistogram():
+    m_counts(internal::getHistogramIndex(MAX_VALUE) + 1, 0) {
+}
+
+void LatencyHistogram::Record(ValueType value) {
+    value = std::min(value, MAX_VALUE);
+
+    ++m_counts[internal::getHistogramIndex(value)];
+    ++m_total_count;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_sum += value;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+    for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_total_count += other.m_total_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+}
+
+ValueType LatencyHistogram::ValueAtPercentile(const double percentile) const {
+    if (m_total_count == 0) {
+        return 0;
+    }
+
+    const auto target = std::max<std::uint64_t>(
+                            1, std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * m_total_count));
+    std::uint64_t cumulative_count = 0;
+    for (std::size_t i = 0; i < m_counts.size(); ++i) {
+        cumulative_count += m_counts[i];
+        if (cumulative_count >= target) {
+            return std::min(internal::getHighestEquivalentValue(i), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+}//namespace psqlxx
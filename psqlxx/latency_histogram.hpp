@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * A log-linear histogram of latencies, in the manner of HdrHistogram: each power of two
+ * is split into SUB_BUCKET_COUNT linear buckets, so a value is kept to within 1/128 of
+ * itself in constant memory.
+ */
+class LatencyHistogram {
+public:
+    using ValueType = std::uint64_t;
+
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr ValueType SUB_BUCKET_COUNT = ValueType{1} << SUB_BUCKET_BITS;
+    // Larger values are recorded as this one
+    static constexpr ValueType MAX_VALUE = (ValueType{1} << 40) - 1;
+
+private:
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total_count = 0;
+    ValueType m_min = MAX_VALUE;
+    ValueType m_max = 0;
+    long double m_sum = 0;
+
+public:
+    LatencyHistogram();
+
+    void Record(ValueType value);
+    void Merge(const LatencyHistogram &other);
+
+    [[nodiscard]]
+    std::uint64_t Count() const {
+        return m_total_count;
+    }
+
+    [[nodiscard]]
+    ValueType Min() const {
+        return m_total_count ? m_min : 0;
+    }
+
+    [[nodiscard]]
+    ValueType Max() const {
+        return m_max;
+    }
+
+    [[nodiscard]]
+    double Mean() const {
+        return m_total_count ? static_cast<double>(m_sum / m_total_count) : 0;
+    }
+
+    /**
+     * @param   percentile  in the range [0, 100].
+     * @return  The highest value equivalent to the one at percentile, or 0 if empty.
+     */
+    [[nodiscard]]
+    ValueType ValueAtPercentile(const double percentile) const;
+};
+
+
+namespace internal {
+
+[[nodiscard]]
+std::size_t getHistogramIndex(const LatencyHistogram::ValueType value);
+
+[[nodiscard]]
+LatencyHistogram::ValueType getHighestEquivalentValue(const std::size_t index);
+
+}//namespace internal
+
+}//namespace psqlxx
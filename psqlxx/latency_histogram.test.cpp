@@ -0,0 +1,74 @@
+#include <psqlxx/latency_histogram.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(GetHistogramIndexTests, CanKeepSmallValuesExact) {
+    for (LatencyHistogram::ValueType value = 0; value < 256; ++value) {
+        ASSERT_EQ(value, internal::getHistogramIndex(value));
+        ASSERT_EQ(value, internal::getHighestEquivalentValue(value));
+    }
+}
+
+TEST(GetHistogramIndexTests, CanBoundRelativeError) {
+    std::size_t previous_index = 0;
+    for (LatencyHistogram::ValueType value = 1; value < LatencyHistogram::MAX_VALUE;
+         value += value / 7 + 1) {
+        const auto index = internal::getHistogramIndex(value);
+        ASSERT_LE(previous_index, index);
+        previous_index = index;
+
+        const auto highest_value = internal::getHighestEquivalentValue(index);
+        ASSERT_LE(value, highest_value);
+        ASSERT_LE(highest_value - value, value / LatencyHistogram::SUB_BUCKET_COUNT);
+        ASSERT_EQ(index, internal::getHistogramIndex(highest_value));
+        ASSERT_EQ(index + 1, internal::getHistogramIndex(highest_value + 1));
+    }
+}
+
+TEST(LatencyHistogramTests, ReturnZerosIfEmpty) {
+    const LatencyHistogram histogram;
+    ASSERT_EQ(0u, histogram.Count());
+    ASSERT_EQ(0u, histogram.Min());
+    ASSERT_EQ(0u, histogram.Max());
+    ASSERT_EQ(0, histogram.Mean());
+    ASSERT_EQ(0u, histogram.ValueAtPercentile(50));
+}
+
+TEST(LatencyHistogramTests, CanReturnPercentiles) {
+    LatencyHistogram histogram;
+    for (LatencyHistogram::ValueType value = 1; value <= 10000; ++value) {
+        histogram.Record(value);
+    }
+
+    ASSERT_EQ(10000u, histogram.Count());
+    ASSERT_EQ(1u, histogram.Min());
+    ASSERT_EQ(10000u, histogram.Max());
+    ASSERT_DOUBLE_EQ(5000.5, histogram.Mean());
+    ASSERT_EQ(1u, histogram.ValueAtPercentile(0));
+    ASSERT_EQ(10000u, histogram.ValueAtPercentile(100));
+
+    for (const auto percentile : {50.0, 95.0, 99.0, 99.9}) {
+        const auto expected = percentile * 100;
+        const auto value = histogram.ValueAtPercentile(percentile);
+        ASSERT_LE(expected, value);
+        ASSERT_GE(expected * 1.01, value);
+    }
+}
+
+TEST(LatencyHistogramTests, CanMerge) {
+    LatencyHistogram histogram;
+    histogram.Record(10);
+    LatencyHistogram other;
+    other.Record(20);
+    other.Record(LatencyHistogram::MAX_VALUE + 1);
+
+    histogram.Merge(other);
+    ASSERT_EQ(3u, histogram.Count());
+    ASSERT_EQ(10u, histogram.Min());
+    ASSERT_EQ(LatencyHistogram::MAX_VALUE, histogram.Max());
+    ASSERT_EQ(20u, histogram.ValueAtPercentile(50));
+}
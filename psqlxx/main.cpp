@@ -1,10 +1,17 @@
+#include <ctime>
 #include <filesystem>
 
 #include <pqxx/pqxx>
 
+#include <psqlxx/agent.hpp>
 #include <psqlxx/args.hpp>
+#include <psqlxx/bench.hpp>
 #include <psqlxx/cli.hpp>
 #include <psqlxx/db.hpp>
+#include <psqlxx/metrics.hpp>
+#include <psqlxx/replay.hpp>
+#include <psqlxx/script_runner.hpp>
+#include <psqlxx/trace.hpp>
 
 
 namespace fs = std::filesystem;
@@ -40,20 +47,44 @@ inline constexpr auto toExitCode(const bool success) {
     return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+/**
+ * Writes the --metrics-file of a -c or -f run, if requested.
+ */
 [[nodiscard]]
-inline std::unique_ptr<FILE, decltype(&fclose)>
-OpenCommandFile(const std::string &command_file) {
-    FILE *file_ptr{};
-    if (not command_file.empty()) {
-        file_ptr = fopen(command_file.c_str(), "r");
-        if (not file_ptr) {
-            std::cerr << "Failed to open command file '" <<
-                      command_file << "': " << strerror(errno) << std::endl;
-            exit(EXIT_FAILURE);
+bool writeMetrics(const DbProxy &db_proxy, const bool succeeded) {
+    const auto &proxy_options = db_proxy.GetOptions();
+    if (proxy_options.metrics_file.empty() or
+        (proxy_options.commands.empty() and proxy_options.command_file.empty())) {
+        return true;
+    }
+
+    return WriteFileAtomically(proxy_options.metrics_file,
+                               db_proxy.GetMetrics().Format(succeeded, std::time(nullptr)));
+}
+
+/**
+ * Runs the -c commands or the -f file.
+ */
+[[nodiscard]]
+bool runNonInteractively(const DbProxy &db_proxy) {
+    const auto &proxy_options = db_proxy.GetOptions();
+
+    if ((proxy_options.pipeline or proxy_options.batch_size > 1) and
+        not proxy_options.commands.empty()) {
+        return RunCommands(db_proxy, proxy_options.commands);
+    }
+
+    if (not proxy_options.commands.empty()) {
+        for (const auto &a_command : proxy_options.commands) {
+            if (not db_proxy.DoTransaction(a_command)) {
+                return false;
+            }
         }
+
+        return true;
     }
 
-    return {file_ptr, &fclose};
+    return RunCommandFile(db_proxy, proxy_options.command_file);
 }
 
 }
@@ -62,8 +93,24 @@ OpenCommandFile(const std::string &command_file) {
 int main(int argc, char **argv) {
     auto options = buildOptions();
 
-    DbProxy db_proxy{handleOptions(options, argc, argv)};
+    auto db_options = handleOptions(options, argc, argv);
+    // Declared first, so that the trace is written after everything else has finished.
+    const TraceSession tracing{db_options.trace_file};
+
+    // Before connecting, which the agent has done already.
+    if (db_options.agent_options.use and not db_options.commands.empty()) {
+        if (not CanRunThroughAgent(db_options)) {
+            return EXIT_FAILURE;
+        }
+        const auto succeeded = RunThroughAgent(db_options);
+        if (succeeded) {
+            return toExitCode(*succeeded);
+        }
+    }
+
+    DbProxy db_proxy{std::move(db_options)};
     if (not db_proxy) {
+        (void) writeMetrics(db_proxy, false);
         return EXIT_FAILURE;
     }
 
@@ -73,19 +120,24 @@ int main(int argc, char **argv) {
         return toExitCode(ListDbs(db_proxy));
     }
 
-    if (not proxy_options.commands.empty()) {
-        for (const auto &a_command : proxy_options.commands) {
-            if (not db_proxy.DoTransaction(a_command)) {
-                return EXIT_FAILURE;
-            }
-        }
+    if (proxy_options.agent_options.serve) {
+        return toExitCode(RunAgent(db_proxy));
+    }
 
-        return EXIT_SUCCESS;
+    if (proxy_options.bench_options.enabled) {
+        return toExitCode(RunBench(db_proxy));
     }
 
-    const auto command_file_ptr = OpenCommandFile(proxy_options.command_file);
+    if (not proxy_options.replay_options.file.empty()) {
+        return toExitCode(RunReplay(db_proxy));
+    }
+
+    if (not proxy_options.commands.empty() or not proxy_options.command_file.empty()) {
+        const auto succeeded = runNonInteractively(db_proxy);
+        return toExitCode(writeMetrics(db_proxy, succeeded) and succeeded);
+    }
 
-    Cli my_cli({fs::path(argv[0]).stem(), command_file_ptr.get()}, db_proxy);
+    Cli my_cli({fs::path(argv[0]).stem(), nullptr}, db_proxy);
     my_cli.Config();
 
     return toExitCode(my_cli.Run());
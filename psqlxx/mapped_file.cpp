@@ -0,0 +1,53 @@
+#include <psqlxx/mapped_file.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+
+namespace psqlxx {
+
+MappedFile::MappedFile(const std::string &path) {
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open file '" << path << "': " << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat file_status {};
+    if (fstat(fd, &file_status) != 0) {
+        std::cerr << "Failed to stat file '" << path << "': " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+
+    m_size = file_status.st_size;
+    // An empty file cannot be mapped, but is a valid empty view.
+    if (m_size > 0) {
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m_data == MAP_FAILED) {
+            std::cerr << "Failed to map file '" << path << "': " << strerror(errno) << std::endl;
+            m_data = nullptr;
+            m_size = 0;
+            close(fd);
+            return;
+        }
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+    m_opened = true;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+}//namespace psqlxx
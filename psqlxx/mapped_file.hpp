@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+
+namespace psqlxx {
+
+/**
+ * A read-only memory mapping of a whole file.
+ */
+class MappedFile {
+    void *m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_opened = false;
+
+public:
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    [[nodiscard]]
+    operator bool() const {
+        return m_opened;
+    }
+
+    [[nodiscard]]
+    std::string_view View() const {
+        return {static_cast<const char *>(m_data), m_size};
+    }
+};
+
+}//namespace psqlxx
@@ -0,0 +1,46 @@
+#include <psqlxx/mapped_file.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+auto writeTempFile(const std::string_view content) {
+    const std::string path = testing::TempDir() + "psqlxx_mapped_file_test";
+    std::ofstream{path, std::ofstream::binary} << content;
+    return path;
+}
+
+}
+
+
+TEST(MappedFileTests, CanViewFileContent) {
+    const auto path = writeTempFile("a,b\n1,2\n");
+    {
+        const MappedFile file{path};
+        ASSERT_TRUE(file);
+        ASSERT_EQ("a,b\n1,2\n", file.View());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(MappedFileTests, CanViewEmptyFile) {
+    const auto path = writeTempFile("");
+    {
+        const MappedFile file{path};
+        ASSERT_TRUE(file);
+        ASSERT_TRUE(file.View().empty());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(MappedFileTests, ReturnFalseIfGivenMissingFile) {
+    ASSERT_FALSE(MappedFile{"/nonexistent/psqlxx_mapped_file_test"});
+}
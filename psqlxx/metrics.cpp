@@ -0,0 +1,121 @@
+#include <psqlxx/metrics.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr std::string_view METRIC_PREFIX = "psqlxx_";
+
+void printFamily(std::ostream &out, const std::string_view name, const std::string_view type,
+                 const std::string_view help) {
+    out << "# HELP " << METRIC_PREFIX << name << ' ' << help << '\n' <<
+        "# TYPE " << METRIC_PREFIX << name << ' ' << type << '\n';
+}
+
+template <typename T>
+void printMetric(std::ostream &out, const std::string_view name, const std::string_view type,
+                 const std::string_view help, const T value) {
+    printFamily(out, name, type, help);
+    out << METRIC_PREFIX << name << ' ' << value << '\n';
+}
+
+}
+
+
+namespace psqlxx {
+
+RunMetrics::RunMetrics(): m_latency_counts(std::size(LATENCY_BUCKETS) + 1, 0) {
+}
+
+void RunMetrics::SetConnectTime(const Duration duration) {
+    m_connect_seconds = std::chrono::duration<double>(duration).count();
+}
+
+void RunMetrics::AddStatement(const Duration duration, const bool succeeded,
+                              const std::int64_t row_count) {
+    ++m_statement_count;
+    if (not succeeded) {
+        ++m_failure_count;
+    }
+    if (row_count > 0) {
+        m_row_count += row_count;
+    }
+
+    const auto seconds = std::chrono::duration<double>(duration).count();
+    const auto bucket = std::lower_bound(std::cbegin(LATENCY_BUCKETS), std::cend(LATENCY_BUCKETS),
+                                         seconds) - std::cbegin(LATENCY_BUCKETS);
+    ++m_latency_counts[bucket];
+    m_latency_sum += seconds;
+}
+
+std::string RunMetrics::Format(const bool run_succeeded, const std::time_t timestamp) const {
+    std::ostringstream out;
+
+    printMetric(out, "connect_seconds", "gauge", "Time taken to connect to the server.",
+                m_connect_seconds);
+    printMetric(out, "statements_total", "counter", "Statements run.", m_statement_count);
+    printMetric(out, "statement_failures_total", "counter", "Statements which failed.",
+                m_failure_count);
+    printMetric(out, "rows_total", "counter", "Rows returned or affected by statements.",
+                m_row_count);
+    printMetric(out, "written_bytes_total", "counter", "Bytes of results written to the output.",
+                m_bytes_written);
+
+    constexpr std::string_view latency_name = "statement_duration_seconds";
+    printFamily(out, latency_name, "histogram", "Statement latencies.");
+    std::uint64_t cumulative_count = 0;
+    for (std::size_t i = 0; i < m_latency_counts.size(); ++i) {
+        cumulative_count += m_latency_counts[i];
+        out << METRIC_PREFIX << latency_name << "_bucket{le=\"";
+        if (i < std::size(LATENCY_BUCKETS)) {
+            out << LATENCY_BUCKETS[i];
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative_count << '\n';
+    }
+    out << METRIC_PREFIX << latency_name << "_sum " << m_latency_sum << '\n' <<
+        METRIC_PREFIX << latency_name << "_count " << cumulative_count << '\n';
+
+    printMetric(out, "run_success", "gauge", "Whether the run succeeded.", run_succeeded ? 1 : 0);
+    printMetric(out, "run_timestamp_seconds", "gauge", "When the run finished, in Unix time.",
+                timestamp);
+
+    return out.str();
+}
+
+bool WriteFileAtomically(const std::string &path, const std::string &content) {
+    // In the same directory, as a rename cannot cross file systems.
+    const auto temp_path = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out{temp_path, std::ofstream::out | std::ofstream::trunc};
+        if (not (out << content << std::flush)) {
+            std::cerr << "Failed to write file '" << temp_path << "': " <<
+                      std::strerror(errno) << std::endl;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to rename file '" << temp_path << "' to '" << path << "': " <<
+                  std::strerror(errno) << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * Counters of one non-interactive run, for monitoring scheduled jobs.
+ */
+class RunMetrics {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    // Upper bounds of the statement latency buckets, in seconds
+    static constexpr double LATENCY_BUCKETS[] = {
+        0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60
+    };
+
+private:
+    double m_connect_seconds = 0;
+
+    std::uint64_t m_statement_count = 0;
+    std::uint64_t m_failure_count = 0;
+    std::uint64_t m_row_count = 0;
+    std::uint64_t m_bytes_written = 0;
+
+    // Not cumulative, the last one counts the statements beyond all bounds
+    std::vector<std::uint64_t> m_latency_counts;
+    double m_latency_sum = 0;
+
+public:
+    RunMetrics();
+
+    void SetConnectTime(const Duration duration);
+
+    /**
+     * @param   row_count   rows returned or affected, negative if unknown.
+     */
+    void AddStatement(const Duration duration, const bool succeeded, const std::int64_t row_count);
+
+    void AddBytesWritten(const std::size_t bytes) {
+        m_bytes_written += bytes;
+    }
+
+    /**
+     * @return  The metrics in the Prometheus text exposition format, as read by the
+     *          node_exporter textfile collector.
+     */
+    [[nodiscard]]
+    std::string Format(const bool run_succeeded, const std::time_t timestamp) const;
+};
+
+/**
+ * Writes content to a temporary file next to path, then renames it over path, so that
+ * readers never see a partial file.
+ *
+ * @return  false after printing the error, if failed.
+ */
+[[nodiscard]]
+bool WriteFileAtomically(const std::string &path, const std::string &content);
+
+}//namespace psqlxx
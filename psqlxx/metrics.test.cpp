@@ -0,0 +1,61 @@
+#include <psqlxx/metrics.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace std::chrono_literals;
+
+
+TEST(RunMetricsTests, CanFormatMetrics) {
+    RunMetrics metrics;
+    metrics.SetConnectTime(250ms);
+    metrics.AddStatement(2ms, true, 10);
+    metrics.AddStatement(20ms, false, -1);
+    metrics.AddStatement(2min, true, 5);
+    metrics.AddBytesWritten(1234);
+
+    const auto text = metrics.Format(false, 1700000000);
+    for (const auto expected : {
+             "# HELP psqlxx_connect_seconds Time taken to connect to the server.\n"
+             "# TYPE psqlxx_connect_seconds gauge\n"
+             "psqlxx_connect_seconds 0.25\n",
+             "# TYPE psqlxx_statements_total counter\npsqlxx_statements_total 3\n",
+             "psqlxx_statement_failures_total 1\n",
+             "psqlxx_rows_total 15\n",
+             "psqlxx_written_bytes_total 1234\n",
+             "# TYPE psqlxx_statement_duration_seconds histogram\n"
+             "psqlxx_statement_duration_seconds_bucket{le=\"0.001\"} 0\n"
+             "psqlxx_statement_duration_seconds_bucket{le=\"0.005\"} 1\n"
+             "psqlxx_statement_duration_seconds_bucket{le=\"0.01\"} 1\n"
+             "psqlxx_statement_duration_seconds_bucket{le=\"0.05\"} 2\n",
+             "psqlxx_statement_duration_seconds_bucket{le=\"60\"} 2\n"
+             "psqlxx_statement_duration_seconds_bucket{le=\"+Inf\"} 3\n"
+             "psqlxx_statement_duration_seconds_sum 120.022\n"
+             "psqlxx_statement_duration_seconds_count 3\n",
+             "psqlxx_run_success 0\n",
+             "psqlxx_run_timestamp_seconds 1700000000\n",
+         }) {
+        ASSERT_NE(std::string::npos, text.find(expected)) << expected;
+    }
+}
+
+TEST(WriteFileAtomicallyTests, CanReplaceFile) {
+    const std::string path = testing::TempDir() + "psqlxx_metrics_test.prom";
+    std::ofstream{path} << "old";
+
+    ASSERT_TRUE(WriteFileAtomically(path, "new\n"));
+    std::ifstream in{path};
+    std::stringstream content;
+    content << in.rdbuf();
+    ASSERT_EQ("new\n", content.str());
+    std::remove(path.c_str());
+}
+
+TEST(WriteFileAtomicallyTests, ReturnFalseIfGivenInvalidPath) {
+    ASSERT_FALSE(WriteFileAtomically(testing::TempDir() + "no/such/dir/metrics.prom", ""));
+}
@@ -0,0 +1,110 @@
+#include <psqlxx/output_buffer.hpp>
+
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include <psqlxx/trace.hpp>
+
+
+namespace {
+
+constexpr std::size_t FILL_TABLE_SIZE = 256;
+
+template <char C>
+[[nodiscard]]
+constexpr auto makeFillTable() {
+    std::array<char, FILL_TABLE_SIZE> table{};
+    for (auto &c : table) {
+        c = C;
+    }
+    return table;
+}
+
+constexpr auto SPACES = makeFillTable<' '>();
+constexpr auto DASHES = makeFillTable<'-'>();
+
+[[nodiscard]]
+inline std::string_view getFillTable(const char c) {
+    switch (c) {
+        case ' ':
+            return {SPACES.data(), SPACES.size()};
+        case '-':
+            return {DASHES.data(), DASHES.size()};
+        default:
+            return {};
+    }
+}
+
+}
+
+
+namespace psqlxx {
+
+OutputBuffer::OutputBuffer(std::ostream &out, const std::size_t capacity):
+    OutputBuffer([&out](std::string & block) {
+    out.write(block.data(), block.size());
+    out.flush();
+    block.clear();
+}, capacity) {
+}
+
+OutputBuffer::OutputBuffer(BlockWriter writer, const std::size_t capacity):
+    m_writer(std::move(writer)), m_capacity(capacity) {
+    m_buffer.reserve(m_capacity);
+}
+
+OutputBuffer::~OutputBuffer() {
+    Flush();
+}
+
+void OutputBuffer::write(const std::string_view data) {
+    Flush();
+    m_buffer.append(data);
+    if (m_buffer.size() >= m_capacity) {
+        Flush();
+    }
+}
+
+OutputBuffer &OutputBuffer::Append(const std::size_t number) {
+    std::array<char, std::numeric_limits<std::size_t>::digits10 + 1> digits{};
+    const auto *const end =
+        std::to_chars(digits.data(), digits.data() + digits.size(), number).ptr;
+    return Append(std::string_view{digits.data(), static_cast<std::size_t>(end - digits.data())});
+}
+
+OutputBuffer &OutputBuffer::AppendFill(const char c, std::size_t count) {
+    const auto table = getFillTable(c);
+    if (table.empty()) {
+        for (; count > 0; --count) {
+            Append(c);
+        }
+        return *this;
+    }
+
+    while (count > 0) {
+        const auto chunk_size = std::min(count, table.size());
+        Append(table.substr(0, chunk_size));
+        count -= chunk_size;
+    }
+    return *this;
+}
+
+void OutputBuffer::Flush() {
+    if (not m_buffer.empty()) {
+        const TraceSpan span{"writeBlock"};
+        m_writer(m_buffer);
+        m_buffer.reserve(m_capacity);
+    }
+}
+
+void OutputBuffer::WriteBlock(std::string &block) {
+    Flush();
+    if (not block.empty()) {
+        const TraceSpan span{"writeBlock"};
+        m_writer(block);
+    }
+}
+
+}//namespace psqlxx
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+
+namespace psqlxx {
+
+/**
+ * A reusable contiguous buffer, which is handed to a block writer in large blocks.
+ */
+class OutputBuffer {
+public:
+    /**
+     * Consumes a full block. It must leave the block empty, but may swap in another string.
+     */
+    using BlockWriter = std::function<void(std::string &block)>;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024;
+
+private:
+    BlockWriter m_writer;
+    const std::size_t m_capacity;
+    std::string m_buffer;
+
+    void write(const std::string_view data);
+
+public:
+    /**
+     * Writes blocks to out and flushes it.
+     */
+    explicit OutputBuffer(std::ostream &out,
+                          const std::size_t capacity = DEFAULT_CAPACITY);
+    explicit OutputBuffer(BlockWriter writer,
+                          const std::size_t capacity = DEFAULT_CAPACITY);
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+    ~OutputBuffer();
+
+    OutputBuffer &Append(const std::string_view data) {
+        if (m_buffer.size() + data.size() <= m_capacity) {
+            m_buffer.append(data);
+        } else {
+            write(data);
+        }
+        return *this;
+    }
+
+    OutputBuffer &Append(const char c) {
+        if (m_buffer.size() >= m_capacity) {
+            Flush();
+        }
+        m_buffer.push_back(c);
+        return *this;
+    }
+
+    OutputBuffer &Append(const std::size_t number);
+
+    /**
+     * Appends count copies of c, copied from a static fill table for spaces and dashes.
+     */
+    OutputBuffer &AppendFill(const char c, std::size_t count);
+
+    /**
+     * Hands everything buffered so far to the block writer.
+     */
+    void Flush();
+
+    /**
+     * Hands an already formatted block to the block writer, after everything buffered.
+     */
+    void WriteBlock(std::string &block);
+
+    [[nodiscard]]
+    auto Size() const {
+        return m_buffer.size();
+    }
+};
+
+}//namespace psqlxx
@@ -0,0 +1,82 @@
+#include <psqlxx/output_buffer.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(OutputBufferTests, NothingIsWrittenBeforeFlush) {
+    std::ostringstream out;
+    OutputBuffer buffer{out};
+    buffer.Append("abc");
+
+    ASSERT_TRUE(out.str().empty());
+    buffer.Flush();
+    ASSERT_EQ("abc", out.str());
+}
+
+TEST(OutputBufferTests, FlushOnDestruction) {
+    std::ostringstream out;
+    {
+        OutputBuffer buffer{out};
+        buffer.Append("abc").Append('d');
+    }
+
+    ASSERT_EQ("abcd", out.str());
+}
+
+TEST(OutputBufferTests, CanAppendNumbers) {
+    std::ostringstream out;
+    OutputBuffer{out}.Append(std::size_t{0}).Append(' ').Append(std::size_t{1234567});
+
+    ASSERT_EQ("0 1234567", out.str());
+}
+
+TEST(OutputBufferTests, AppendFillLongerThanFillTable) {
+    std::ostringstream out;
+    OutputBuffer{out}.AppendFill(' ', 1000).AppendFill('-', 300).AppendFill('*', 3);
+
+    ASSERT_EQ(std::string(1000, ' ') + std::string(300, '-') + "***", out.str());
+}
+
+TEST(OutputBufferTests, KeepOrderWhenDataExceedsCapacity) {
+    std::ostringstream out;
+    const std::string LARGE(100, 'x');
+    {
+        OutputBuffer buffer{out, 16};
+        buffer.Append("head").Append(LARGE).Append("tail").AppendFill('-', 20);
+    }
+
+    ASSERT_EQ("head" + LARGE + "tail" + std::string(20, '-'), out.str());
+}
+
+TEST(OutputBufferTests, BlockWriterReceivesFullBlocks) {
+    std::vector<std::string> blocks;
+    {
+        OutputBuffer buffer{[&blocks](std::string & block) {
+            blocks.push_back(std::move(block));
+            block = {};
+        }, 4};
+        buffer.Append("abcd").Append("ef").Append('g');
+    }
+
+    ASSERT_EQ((std::vector<std::string>{"abcd", "efg"}), blocks);
+}
+
+TEST(OutputBufferTests, WriteBlockAfterBufferedData) {
+    std::ostringstream out;
+    std::string block = "block";
+    {
+        OutputBuffer buffer{out};
+        buffer.Append("head ");
+        buffer.WriteBlock(block);
+        buffer.Append(" tail");
+    }
+
+    ASSERT_EQ("head block tail", out.str());
+    ASSERT_TRUE(block.empty());
+}
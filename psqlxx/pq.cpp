@@ -0,0 +1,153 @@
+#include <psqlxx/pq.hpp>
+#include <psqlxx/binary_decoder.hpp>
+
+#include <poll.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+auto getBinaryDecoders(const PGresult *a_result, const TypeMap &type_map) {
+    std::vector<BinaryDecoder> decoders(PQnfields(a_result));
+    for (std::size_t i = 0; i < decoders.size(); ++i) {
+        const auto type_iter = type_map.find(PQftype(a_result, i));
+        if (type_iter != type_map.cend()) {
+            decoders[i] = GetBinaryDecoder(type_iter->second);
+        }
+    }
+    return decoders;
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace pq {
+
+ConnectionPtr Connect(const std::string &connection_string) {
+    ConnectionPtr a_connection{PQconnectdb(connection_string.c_str())};
+    if (PQstatus(a_connection.get()) != CONNECTION_OK) {
+        std::cerr << PQerrorMessage(a_connection.get()) << std::endl;
+        return {};
+    }
+    return a_connection;
+}
+
+bool CheckResult(const PGconn *a_connection, const PGresult *a_result) {
+    if (not a_result) {
+        std::cerr << PQerrorMessage(a_connection) << std::endl;
+        return false;
+    }
+
+    switch (PQresultStatus(a_result)) {
+        case PGRES_BAD_RESPONSE:
+        case PGRES_NONFATAL_ERROR:
+        case PGRES_FATAL_ERROR:
+            std::cerr << PQresultErrorMessage(a_result) << std::endl;
+            return false;
+        default:
+            return true;
+    }
+}
+
+bool FinishCommand(PGconn *a_connection) {
+    auto succeeded = true;
+    while (const ResultPtr a_result{PQgetResult(a_connection)}) {
+        succeeded = CheckResult(a_connection, a_result.get()) and succeeded;
+    }
+    return succeeded;
+}
+
+bool Cancel(PGcancel *a_cancel) {
+    char error[256] = "no cancel object";
+    if (not a_cancel or PQcancel(a_cancel, error, sizeof(error)) != 1) {
+        std::cerr << "Failed to cancel the statement: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WaitForInput(PGconn *a_connection) {
+    pollfd socket_fd{PQsocket(a_connection), POLLIN, 0};
+    while (poll(&socket_fd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            std::cerr << "Failed to wait for the server: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ExecCommand(PGconn *a_connection, const std::string &sql) {
+    const ResultPtr a_result{PQexec(a_connection, sql.c_str())};
+    return CheckResult(a_connection, a_result.get());
+}
+
+bool CopyOut(PGconn *a_connection, const std::string &copy_sql, std::ostream &out,
+             std::size_t *bytes_written) {
+    const ResultPtr copy_result{PQexec(a_connection, copy_sql.c_str())};
+    if (not CheckResult(a_connection, copy_result.get())) {
+        return false;
+    }
+
+    // Rows go from libpq's buffer to the output as they are, without being parsed.
+    char *row = nullptr;
+    int length = 0;
+    while ((length = PQgetCopyData(a_connection, &row, 0)) > 0) {
+        out.write(row, length);
+        PQfreemem(row);
+        if (bytes_written) {
+            *bytes_written += length;
+        }
+    }
+    out.flush();
+
+    return FinishCommand(a_connection);
+}
+
+}//namespace pq
+
+
+PqResult::PqResult(pq::ResultPtr a_result, const TypeMap &type_map):
+    m_result(std::move(a_result)) {
+    const auto *const raw_result = m_result.get();
+    const auto column_count = columns();
+    if (column_count == 0 or PQfformat(raw_result, 0) == 0) {
+        return;
+    }
+
+    const auto decoders = getBinaryDecoders(raw_result, type_map);
+    const auto row_count = size();
+    m_value_ends.reserve(static_cast<std::size_t>(row_count) * column_count);
+    for (int i = 0; i < row_count; ++i) {
+        for (int j = 0; j < column_count; ++j) {
+            if (decoders[j] and not PQgetisnull(raw_result, i, j)) {
+                decoders[j]({PQgetvalue(raw_result, i, j),
+                             static_cast<std::size_t>(PQgetlength(raw_result, i, j))},
+                            m_decoded_values);
+            }
+            m_value_ends.push_back(m_decoded_values.size());
+        }
+    }
+}
+
+std::string_view PqResult::GetValue(const int row, const int column) const {
+    if (m_value_ends.empty()) {
+        return {PQgetvalue(m_result.get(), row, column),
+                static_cast<std::size_t>(PQgetlength(m_result.get(), row, column))};
+    }
+
+    const auto index = static_cast<std::size_t>(row) * columns() + column;
+    const auto begin = index == 0 ? 0 : m_value_ends[index - 1];
+    return std::string_view{m_decoded_values}.substr(begin, m_value_ends[index] - begin);
+}
+
+}//namespace psqlxx
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libpq-fe.h>
+
+#include <psqlxx/formatter.hpp>
+
+
+namespace psqlxx {
+
+/**
+ * Thin RAII wrappers for the libpq features that pqxx does not expose.
+ */
+namespace pq {
+
+struct ConnectionDeleter {
+    void operator()(PGconn *a_connection) const {
+        PQfinish(a_connection);
+    }
+};
+
+struct ResultDeleter {
+    void operator()(PGresult *a_result) const {
+        PQclear(a_result);
+    }
+};
+
+struct CancelDeleter {
+    void operator()(PGcancel *a_cancel) const {
+        PQfreeCancel(a_cancel);
+    }
+};
+
+struct ConninfoDeleter {
+    void operator()(PQconninfoOption *options) const {
+        PQconninfoFree(options);
+    }
+};
+
+using ConnectionPtr = std::unique_ptr<PGconn, ConnectionDeleter>;
+using ResultPtr = std::unique_ptr<PGresult, ResultDeleter>;
+using CancelPtr = std::unique_ptr<PGcancel, CancelDeleter>;
+using ConninfoPtr = std::unique_ptr<PQconninfoOption, ConninfoDeleter>;
+
+/**
+ * @return  Null after printing the error, if failed to connect.
+ */
+[[nodiscard]]
+ConnectionPtr Connect(const std::string &connection_string);
+
+/**
+ * @return  false after printing the error, if a_result is null or failed.
+ */
+[[nodiscard]]
+bool CheckResult(const PGconn *a_connection, const PGresult *a_result);
+
+/**
+ * Consumes the remaining results of the command in progress.
+ *
+ * @return  false after printing the errors, if any of them failed.
+ */
+[[nodiscard]]
+bool FinishCommand(PGconn *a_connection);
+
+/**
+ * Asks the server to cancel the command in progress. Safe to call from any thread.
+ *
+ * @return  false after printing the error, if failed to send the request.
+ */
+bool Cancel(PGcancel *a_cancel);
+
+/**
+ * Blocks until the server has sent something to read.
+ *
+ * @return  false after printing the error, if failed to poll the connection.
+ */
+[[nodiscard]]
+bool WaitForInput(PGconn *a_connection);
+
+/**
+ * Runs a command which returns no rows.
+ */
+[[nodiscard]]
+bool ExecCommand(PGconn *a_connection, const std::string &sql);
+
+/**
+ * Runs a COPY ... TO STDOUT command, and writes its rows to out as they arrive.
+ *
+ * @param   bytes_written   if not null, receives the count of bytes written to out.
+ */
+[[nodiscard]]
+bool CopyOut(PGconn *a_connection, const std::string &copy_sql, std::ostream &out,
+             std::size_t *bytes_written = nullptr);
+
+}//namespace pq
+
+
+/**
+ * A libpq result, which offers the part of the pqxx::result interface used by the formatter.
+ *
+ * @note    Binary values are decoded on construction, to the text the server would have sent.
+ */
+class PqResult {
+    pq::ResultPtr m_result;
+
+    std::string m_decoded_values;
+    // End offset in m_decoded_values of each value, row by row
+    std::vector<std::size_t> m_value_ends;
+
+public:
+    class Field {
+        std::string_view m_value;
+
+    public:
+        explicit Field(const std::string_view value): m_value(value) {
+        }
+
+        [[nodiscard]]
+        std::string_view view() const {
+            return m_value;
+        }
+    };
+
+    class Row {
+        const PqResult &m_home;
+        int m_row;
+
+    public:
+        Row(const PqResult &home, const int row): m_home(home), m_row(row) {
+        }
+
+        [[nodiscard]]
+        bool empty() const {
+            return m_home.columns() == 0;
+        }
+
+        [[nodiscard]]
+        Field operator[](const int column) const {
+            return Field{m_home.GetValue(m_row, column)};
+        }
+
+        [[nodiscard]]
+        Field back() const {
+            return (*this)[m_home.columns() - 1];
+        }
+    };
+
+    PqResult(pq::ResultPtr a_result, const TypeMap &type_map);
+
+    [[nodiscard]]
+    int columns() const {
+        return PQnfields(m_result.get());
+    }
+
+    [[nodiscard]]
+    int size() const {
+        return PQntuples(m_result.get());
+    }
+
+    [[nodiscard]]
+    const char *column_name(const int column) const {
+        return PQfname(m_result.get(), column);
+    }
+
+    [[nodiscard]]
+    Oid column_type(const int column) const {
+        return PQftype(m_result.get(), column);
+    }
+
+    [[nodiscard]]
+    Row operator[](const int row) const {
+        return {*this, row};
+    }
+
+    [[nodiscard]]
+    std::size_t MemorySize() const {
+        return PQresultMemorySize(m_result.get()) + m_decoded_values.capacity() +
+               m_value_ends.capacity() * sizeof(std::size_t);
+    }
+
+    [[nodiscard]]
+    std::string_view GetValue(const int row, const int column) const;
+};
+
+}//namespace psqlxx
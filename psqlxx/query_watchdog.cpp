@@ -0,0 +1,130 @@
+#include <psqlxx/query_watchdog.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+
+namespace psqlxx {
+
+QueryWatchdog::QueryWatchdog() {
+    // Non-blocking, so that a signal handler never waits on a full pipe.
+    if (pipe2(m_wake_fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::cerr << "Failed to create the query watchdog: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    m_thread = std::thread{[this] {
+        run();
+    }};
+}
+
+QueryWatchdog::~QueryWatchdog() {
+    if (m_thread.joinable()) {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_stopping = true;
+        }
+        wake();
+        m_thread.join();
+    }
+
+    for (const auto fd : m_wake_fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void QueryWatchdog::wake() noexcept {
+    const auto saved_errno = errno;
+    // A full pipe wakes the thread up all the same.
+    (void) !write(m_wake_fds[1], "", 1);
+    errno = saved_errno;
+}
+
+void QueryWatchdog::end() {
+    m_in_flight = false;
+
+    // Waits for a cancellation in progress, which may still use the statement's connection.
+    const std::lock_guard lock{m_mutex};
+    m_cancel = {};
+    m_deadline.reset();
+}
+
+QueryWatchdog::Watch QueryWatchdog::Begin(CancelFunction cancel, const Clock::duration timeout) {
+    {
+        const std::lock_guard lock{m_mutex};
+        m_cancel = std::move(cancel);
+        if (timeout > timeout.zero()) {
+            m_deadline = Clock::now() + timeout;
+        }
+        m_cancel_requested = false;
+        m_in_flight = true;
+    }
+    if (timeout > timeout.zero()) {
+        wake();
+    }
+
+    return Watch{*this};
+}
+
+bool QueryWatchdog::RequestCancel() noexcept {
+    if (not m_in_flight or m_wake_fds[1] < 0) {
+        return false;
+    }
+
+    m_cancel_requested = true;
+    wake();
+    return true;
+}
+
+void QueryWatchdog::run() {
+    while (true) {
+        auto timeout_ms = -1;
+        {
+            const std::lock_guard lock{m_mutex};
+            if (m_stopping) {
+                return;
+            }
+            if (m_cancel and m_deadline) {
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                                           *m_deadline - Clock::now());
+                timeout_ms = std::max<std::chrono::milliseconds::rep>(remaining.count(), 0);
+            }
+        }
+
+        pollfd wake_fd{m_wake_fds[0], POLLIN, 0};
+        if (poll(&wake_fd, 1, timeout_ms) < 0 and errno != EINTR) {
+            std::cerr << "Query watchdog failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        char wake_bytes[64];
+        while (read(m_wake_fds[0], wake_bytes, sizeof(wake_bytes)) > 0);
+
+        const std::lock_guard lock{m_mutex};
+        if (m_stopping) {
+            return;
+        }
+        if (not m_cancel) {
+            continue;
+        }
+
+        const auto timed_out = m_deadline and Clock::now() >= *m_deadline;
+        if (m_cancel_requested.exchange(false) or timed_out) {
+            if (timed_out) {
+                std::cerr << "Statement timeout reached, cancelling the statement." << std::endl;
+            }
+            m_cancel();
+            m_cancel = {};
+            m_deadline.reset();
+        }
+    }
+}
+
+}//namespace psqlxx
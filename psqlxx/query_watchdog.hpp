@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+
+namespace psqlxx {
+
+/**
+ * Cancels the statement in flight from a thread of its own, when asked to from a signal
+ * handler, or once it has run for too long. The statement fails, while its connection
+ * survives.
+ */
+class QueryWatchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+    using CancelFunction = std::function<void()>;
+
+    /**
+     * Watches a statement until it is destroyed.
+     */
+    class Watch {
+        QueryWatchdog &m_watchdog;
+
+    public:
+        explicit Watch(QueryWatchdog &watchdog): m_watchdog(watchdog) {
+        }
+        Watch(const Watch &) = delete;
+        Watch &operator=(const Watch &) = delete;
+
+        ~Watch() {
+            m_watchdog.end();
+        }
+    };
+
+private:
+    // The watchdog thread waits on the read end, and is woken up by writes.
+    int m_wake_fds[2] = {-1, -1};
+
+    std::mutex m_mutex;
+    // Of the statement in flight, empty if none or if cancelled
+    CancelFunction m_cancel;
+    std::optional<Clock::time_point> m_deadline;
+    bool m_stopping = false;
+
+    std::atomic<bool> m_in_flight{false};
+    std::atomic<bool> m_cancel_requested{false};
+
+    std::thread m_thread;
+
+    void wake() noexcept;
+    void end();
+    void run();
+
+public:
+    QueryWatchdog();
+    QueryWatchdog(const QueryWatchdog &) = delete;
+    QueryWatchdog &operator=(const QueryWatchdog &) = delete;
+    ~QueryWatchdog();
+
+    /**
+     * @param   cancel  called on the watchdog thread, at most once, while the Watch lives.
+     * @param   timeout zero for none.
+     */
+    [[nodiscard]]
+    Watch Begin(CancelFunction cancel, const Clock::duration timeout);
+
+    /**
+     * Asks to cancel the statement in flight. Safe to call from a signal handler.
+     *
+     * @return  false if no statement is in flight.
+     */
+    bool RequestCancel() noexcept;
+};
+
+}//namespace psqlxx
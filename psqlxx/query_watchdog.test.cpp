@@ -0,0 +1,82 @@
+#include <psqlxx/query_watchdog.hpp>
+
+#include <condition_variable>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace std::chrono_literals;
+
+
+namespace {
+
+/**
+ * Stands in for a statement, which runs until it is cancelled or times out.
+ */
+class FakeStatement {
+    std::mutex m_mutex;
+    std::condition_variable m_cancelled_condition;
+    bool m_cancelled = false;
+
+public:
+    void Cancel() {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_cancelled = true;
+        }
+        m_cancelled_condition.notify_all();
+    }
+
+    [[nodiscard]]
+    bool WaitForCancel(const std::chrono::milliseconds timeout) {
+        std::unique_lock lock{m_mutex};
+        return m_cancelled_condition.wait_for(lock, timeout, [this] {
+            return m_cancelled;
+        });
+    }
+};
+
+}
+
+
+TEST(QueryWatchdogTests, CanCancelOnRequest) {
+    QueryWatchdog watchdog;
+    ASSERT_FALSE(watchdog.RequestCancel());
+
+    FakeStatement statement;
+    {
+        const auto watch = watchdog.Begin([&statement] {
+            statement.Cancel();
+        }, {});
+        ASSERT_FALSE(statement.WaitForCancel(20ms));
+        ASSERT_TRUE(watchdog.RequestCancel());
+        ASSERT_TRUE(statement.WaitForCancel(5s));
+    }
+
+    ASSERT_FALSE(watchdog.RequestCancel());
+}
+
+TEST(QueryWatchdogTests, CanCancelOnTimeout) {
+    QueryWatchdog watchdog;
+
+    FakeStatement statement;
+    const auto begin = QueryWatchdog::Clock::now();
+    const auto watch = watchdog.Begin([&statement] {
+        statement.Cancel();
+    }, 50ms);
+    ASSERT_TRUE(statement.WaitForCancel(5s));
+    ASSERT_LE(50ms, QueryWatchdog::Clock::now() - begin);
+}
+
+TEST(QueryWatchdogTests, CanSkipCancelIfStatementEnded) {
+    QueryWatchdog watchdog;
+
+    FakeStatement statement;
+    {
+        const auto watch = watchdog.Begin([&statement] {
+            statement.Cancel();
+        }, 50ms);
+    }
+    ASSERT_FALSE(statement.WaitForCancel(100ms));
+}
@@ -1,5 +1,7 @@
 #include <psqlxx/db.hpp>
 
+#include <sstream>
+
 #include <pqxx/pqxx>
 #include <gtest/gtest.h>
 
@@ -35,3 +37,35 @@ TEST(MakeConnectionTests, ReturnNullptrIfGivenWrongPasswordAndNoPrompt) {
     ASSERT_FALSE(internal::makeConnection(options));
 }
 
+
+TEST(BinaryResultsTests, CanSeeTemporaryTableOfSession) {
+    ConnectionOptions connection_options;
+    connection_options.prompt_for_password = false;
+    connection_options.base_connection_string = GetViewerConnectionString();
+    DbProxyOptions options{connection_options, FormatterOptions{}};
+    options.binary_results = true;
+
+    std::stringstream output;
+    const DbProxy proxy{options};
+    proxy.SetOutput(output.rdbuf());
+
+    ASSERT_TRUE(proxy.DoTransaction("CREATE TEMPORARY TABLE binary_results AS SELECT 42 AS answer"));
+    ASSERT_TRUE(proxy.DoTransaction("SELECT answer FROM binary_results"));
+    ASSERT_NE(std::string::npos, output.str().find("42"));
+}
+
+TEST(CopyOutTests, CanSeeTemporaryTableOfSession) {
+    ConnectionOptions connection_options;
+    connection_options.prompt_for_password = false;
+    connection_options.base_connection_string = GetViewerConnectionString();
+    DbProxyOptions options{connection_options, FormatterOptions{}};
+    options.copy_format = "csv";
+
+    std::stringstream output;
+    const DbProxy proxy{options};
+    proxy.SetOutput(output.rdbuf());
+
+    ASSERT_TRUE(proxy.DoTransaction("CREATE TEMPORARY TABLE copy_out AS SELECT 42 AS answer"));
+    ASSERT_TRUE(proxy.DoTransaction("SELECT answer FROM copy_out"));
+    ASSERT_EQ("answer\n42\n", output.str());
+}
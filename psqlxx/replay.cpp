@@ -0,0 +1,286 @@
+#include <psqlxx/replay.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include <psqlxx/db.hpp>
+#include <psqlxx/latency_histogram.hpp>
+#include <psqlxx/pq.hpp>
+#include <psqlxx/session_state.hpp>
+#include <psqlxx/string_utils.hpp>
+#include <psqlxx/workload_capture.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Count of statements whose slowdown is listed in the report
+constexpr std::size_t SLOWEST_COUNT = 5;
+
+struct ReplayedStatement {
+    std::int64_t duration_us = 0;
+    std::int64_t row_count = -1;
+    bool succeeded = false;
+};
+
+/**
+ * Runs a_statement on a_connection, once it is due.
+ */
+[[nodiscard]]
+ReplayedStatement replay(PGconn *const a_connection, const CapturedStatement &a_statement,
+                         const Clock::time_point begin, const double speed) {
+    if (speed > 0) {
+        std::this_thread::sleep_until(begin + std::chrono::microseconds(
+                                          static_cast<std::int64_t>(a_statement.offset_us / speed)));
+    }
+
+    ReplayedStatement replayed;
+    const auto start = Clock::now();
+    const pq::ResultPtr a_result{PQexec(a_connection, a_statement.sql.c_str())};
+    replayed.duration_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+    replayed.succeeded = pq::CheckResult(a_connection, a_result.get());
+    if (replayed.succeeded) {
+        const std::string_view affected_rows = PQcmdTuples(a_result.get());
+        replayed.row_count = affected_rows.empty() ? -1 : std::stoll(std::string{affected_rows});
+    }
+    return replayed;
+}
+
+/**
+ * @return  true if sql_cmd, run in a transaction block, leaves it.
+ */
+[[nodiscard]]
+bool endsTransactionBlock(std::string_view sql_cmd) {
+    const auto keyword = PopKeyword(sql_cmd);
+    if (EqualsIgnoreCase(keyword, "prepare")) {
+        return EqualsIgnoreCase(PopKeyword(sql_cmd), "transaction");
+    }
+    if (not EqualsIgnoreCase(keyword, "commit") and not EqualsIgnoreCase(keyword, "end") and
+        not EqualsIgnoreCase(keyword, "rollback") and not EqualsIgnoreCase(keyword, "abort")) {
+        return false;
+    }
+
+    // ROLLBACK TO a savepoint stays in the block, AND CHAIN begins the next one at once.
+    auto next_keyword = PopKeyword(sql_cmd);
+    if (EqualsIgnoreCase(next_keyword, "work") or EqualsIgnoreCase(next_keyword, "transaction")) {
+        next_keyword = PopKeyword(sql_cmd);
+    }
+    if (EqualsIgnoreCase(next_keyword, "to")) {
+        return false;
+    }
+    return not(EqualsIgnoreCase(next_keyword, "and") and
+               EqualsIgnoreCase(PopKeyword(sql_cmd), "chain"));
+}
+
+/**
+ * Replays the units in [first_unit, last_unit), each on the next free connection once its
+ * previous one has completed.
+ */
+void replayUnits(const std::vector<pq::ConnectionPtr> &connections,
+                 const std::vector<CapturedStatement> &captured,
+                 const std::vector<std::size_t> &unit_begins,
+                 const std::size_t first_unit, const std::size_t last_unit,
+                 const Clock::time_point begin, const double speed,
+                 std::vector<ReplayedStatement> &replayed) {
+    std::atomic_size_t next_unit = first_unit;
+    std::vector<std::thread> threads;
+    threads.reserve(connections.size());
+    for (const auto &a_connection : connections) {
+        threads.emplace_back([&captured, &unit_begins, last_unit, begin, speed, &replayed,
+                                         &next_unit, raw_connection = a_connection.get()] {
+            for (auto unit = next_unit++; unit < last_unit; unit = next_unit++) {
+                for (auto i = unit_begins[unit]; i < unit_begins[unit + 1]; ++i) {
+                    replayed[i] = replay(raw_connection, captured[i], begin, speed);
+                }
+            }
+        });
+    }
+    for (auto &a_thread : threads) {
+        a_thread.join();
+    }
+}
+
+[[nodiscard]]
+inline double toMilliseconds(const double microseconds) {
+    return microseconds / 1000;
+}
+
+void printLatencies(const std::string_view title, const LatencyHistogram &latencies) {
+    std::cout << title << " latency average: " << toMilliseconds(latencies.Mean()) <<
+              " ms, p50: " << toMilliseconds(latencies.ValueAtPercentile(50)) <<
+              " ms, p95: " << toMilliseconds(latencies.ValueAtPercentile(95)) <<
+              " ms, p99: " << toMilliseconds(latencies.ValueAtPercentile(99)) <<
+              " ms, max: " << toMilliseconds(latencies.Max()) << " ms\n";
+}
+
+void printReport(const std::vector<CapturedStatement> &captured,
+                 const std::vector<ReplayedStatement> &replayed,
+                 const Clock::duration elapsed) {
+    LatencyHistogram captured_latencies;
+    LatencyHistogram replayed_latencies;
+    std::size_t failed_count = 0;
+    std::size_t row_count_mismatches = 0;
+    std::vector<std::size_t> slowed_down;
+    for (std::size_t i = 0; i < captured.size(); ++i) {
+        if (not replayed[i].succeeded) {
+            ++failed_count;
+            continue;
+        }
+
+        captured_latencies.Record(std::max<std::int64_t>(captured[i].duration_us, 0));
+        replayed_latencies.Record(replayed[i].duration_us);
+        if (captured[i].row_count >= 0 and replayed[i].row_count >= 0 and
+            captured[i].row_count != replayed[i].row_count) {
+            ++row_count_mismatches;
+        }
+        slowed_down.push_back(i);
+    }
+
+    const auto slowdown = [&captured, &replayed](const auto i) {
+        return replayed[i].duration_us - captured[i].duration_us;
+    };
+    const auto slowest_count = std::min(SLOWEST_COUNT, slowed_down.size());
+    std::partial_sort(slowed_down.begin(), slowed_down.begin() + slowest_count,
+                      slowed_down.end(), [&slowdown](const auto lhs, const auto rhs) {
+        return slowdown(lhs) > slowdown(rhs);
+    });
+
+    const auto captured_seconds = captured.empty() ? 0 : captured.back().offset_us / 1e6;
+    std::cout << std::fixed << std::setprecision(3) <<
+              "statements: " << captured.size() << ", " << failed_count << " failed, " <<
+              row_count_mismatches << " with different row counts\n" <<
+              "duration: " << std::chrono::duration<double>(elapsed).count() <<
+              " s replayed, " << captured_seconds << " s captured\n";
+    printLatencies("captured", captured_latencies);
+    printLatencies("replayed", replayed_latencies);
+
+    for (std::size_t i = 0; i < slowest_count and slowdown(slowed_down[i]) > 0; ++i) {
+        const auto &a_statement = captured[slowed_down[i]];
+        std::cout << "slower by " << toMilliseconds(slowdown(slowed_down[i])) << " ms: " <<
+                  a_statement.sql.substr(0, a_statement.sql.find('\n')) << '\n';
+    }
+    std::cout << std::defaultfloat << std::flush;
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::vector<std::size_t> findReplayUnits(const std::vector<CapturedStatement> &statements) {
+    std::vector<std::size_t> unit_begins;
+    auto in_transaction_block = false;
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        if (not in_transaction_block) {
+            unit_begins.push_back(i);
+        }
+
+        std::string_view sql_cmd = statements[i].sql;
+        const auto keyword = PopKeyword(sql_cmd);
+        if (EqualsIgnoreCase(keyword, "begin") or EqualsIgnoreCase(keyword, "start")) {
+            in_transaction_block = true;
+        } else if (in_transaction_block and endsTransactionBlock(statements[i].sql)) {
+            in_transaction_block = false;
+        }
+    }
+
+    return unit_begins;
+}
+
+}//namespace internal
+
+
+void AddReplayOptions(cxxopts::Options &options) {
+    options.add_options("Replay")
+    ("replay", "replay the statements of a --capture FILE, then compare their latencies",
+     cxxopts::value<std::string>()->default_value(""), "FILE")
+    ("replay-connections", "number of connections to replay the statements on",
+     cxxopts::value<std::size_t>()->default_value("1"), "N")
+    ("replay-speed",
+     "replay FACTOR times faster than captured, 0 to replay as fast as possible",
+     cxxopts::value<double>()->default_value("1"), "FACTOR")
+    ;
+}
+
+ReplayOptions HandleReplayOptions(const cxxopts::ParseResult &parsed_options) {
+    ReplayOptions options{};
+
+    options.file = parsed_options["replay"].as<std::string>();
+    options.connections =
+        std::max<std::size_t>(parsed_options["replay-connections"].as<std::size_t>(), 1);
+    options.speed = std::max(parsed_options["replay-speed"].as<double>(), 0.0);
+
+    return options;
+}
+
+bool RunReplay(const DbProxy &proxy) {
+    const auto &options = proxy.GetOptions().replay_options;
+
+    const auto captured = ReadCapture(options.file);
+    if (not captured) {
+        return false;
+    }
+
+    // A transaction block runs on one connection, or its statements would not be in it.
+    auto unit_begins = internal::findReplayUnits(*captured);
+    const auto unit_count = unit_begins.size();
+    unit_begins.push_back(captured->size());
+
+    std::vector<pq::ConnectionPtr> connections(std::min(options.connections, unit_count));
+    for (auto &a_connection : connections) {
+        a_connection = pq::Connect(proxy.GetConnectionString());
+        if (not a_connection) {
+            return false;
+        }
+    }
+
+    // A session change, outside of a transaction block, is replayed on every connection,
+    // once the units before it have completed, so that all later units see it.
+    const auto is_session_change = [&captured, &unit_begins](const auto unit) {
+        return unit_begins[unit + 1] - unit_begins[unit] == 1 and
+               SessionState::IsChange((*captured)[unit_begins[unit]].sql);
+    };
+
+    std::vector<ReplayedStatement> replayed(captured->size());
+    const auto begin = Clock::now();
+    for (std::size_t unit = 0; unit < unit_count; ++unit) {
+        auto segment_end = unit;
+        while (segment_end < unit_count and not is_session_change(segment_end)) {
+            ++segment_end;
+        }
+        replayUnits(connections, *captured, unit_begins, unit, segment_end, begin, options.speed,
+                    replayed);
+        if (segment_end == unit_count) {
+            break;
+        }
+
+        const auto i = unit_begins[segment_end];
+        replayed[i] = replay(connections.front().get(), (*captured)[i], begin, options.speed);
+        for (std::size_t j = 1; j < connections.size(); ++j) {
+            replayed[i].succeeded = replay(connections[j].get(), (*captured)[i], begin,
+                                           options.speed).succeeded and replayed[i].succeeded;
+        }
+        unit = segment_end;
+    }
+
+    printReport(*captured, replayed, Clock::now() - begin);
+    return std::all_of(replayed.cbegin(), replayed.cend(), [](const auto &a_statement) {
+        return a_statement.succeeded;
+    });
+}
+
+}//namespace psqlxx
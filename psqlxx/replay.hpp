@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace cxxopts {
+
+class Options;
+class ParseResult;
+
+}
+
+
+namespace psqlxx {
+
+class DbProxy;
+struct CapturedStatement;
+
+
+struct ReplayOptions {
+    // Capture file to replay, empty to not replay
+    std::string file;
+
+    std::size_t connections = 1;
+
+    // Replay so many times faster than captured, 0 to replay as fast as possible
+    double speed = 1;
+};
+
+void AddReplayOptions(cxxopts::Options &options);
+
+[[nodiscard]]
+ReplayOptions HandleReplayOptions(const cxxopts::ParseResult &parsed_options);
+
+
+/**
+ * Re-issues the statements of a --capture file on connections of its own, each at its
+ * captured offset scaled by the speed, then compares the replayed latencies to the
+ * captured ones.
+ *
+ * @note    Statements are handed to the connections in captured order, a transaction block
+ *          as a whole, so that it runs on one session. A statement changing the session state
+ *          outside of a block runs on every connection, after all statements before it.
+ *
+ * @return  false if any statement failed.
+ */
+[[nodiscard]]
+bool RunReplay(const DbProxy &proxy);
+
+
+namespace internal {
+
+/**
+ * @return  The index of the first statement of each unit to replay on one connection:
+ *          a transaction block, from its BEGIN to its COMMIT or ROLLBACK, or a single
+ *          statement outside of one.
+ */
+[[nodiscard]]
+std::vector<std::size_t> findReplayUnits(const std::vector<CapturedStatement> &statements);
+
+}//namespace internal
+
+}//namespace psqlxx
@@ -0,0 +1,43 @@
+#include <psqlxx/replay.hpp>
+#include <psqlxx/workload_capture.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+std::vector<CapturedStatement> toCaptured(const std::vector<std::string> &sql_cmds) {
+    std::vector<CapturedStatement> statements;
+    for (const auto &a_sql_cmd : sql_cmds) {
+        statements.push_back({0, 0, -1, a_sql_cmd});
+    }
+    return statements;
+}
+
+}
+
+
+TEST(FindReplayUnitsTests, ReturnEachStatementOutsideTransactionBlocks) {
+    const auto statements = toCaptured({"select 1", "select 2", "select 3"});
+
+    ASSERT_EQ((std::vector<std::size_t> {0, 1, 2}), internal::findReplayUnits(statements));
+}
+
+TEST(FindReplayUnitsTests, CanKeepTransactionBlockTogether) {
+    const auto statements = toCaptured({"select 1", "BEGIN", "insert into t values (1)",
+                                        "COMMIT", "select 2", "start transaction", "select 3",
+                                        "rollback"});
+
+    ASSERT_EQ((std::vector<std::size_t> {0, 1, 4, 5}), internal::findReplayUnits(statements));
+}
+
+TEST(FindReplayUnitsTests, CanStayInTransactionBlock) {
+    const auto statements = toCaptured({"begin", "savepoint a", "rollback to savepoint a",
+                                        "commit and chain", "select 1", "end", "select 2"});
+
+    ASSERT_EQ((std::vector<std::size_t> {0, 6}), internal::findReplayUnits(statements));
+}
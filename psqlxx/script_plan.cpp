@@ -0,0 +1,149 @@
+#include <psqlxx/script_plan.hpp>
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include <psqlxx/sql_splitter.hpp>
+#include <psqlxx/string_utils.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr std::string_view WHITESPACES = " \t\r\f\v";
+constexpr std::string_view ANNOTATION_PREFIX = "psqlxx:";
+
+struct Annotations {
+    std::string_view id;
+    std::vector<std::string_view> after;
+    bool barrier = false;
+};
+
+[[nodiscard]]
+inline std::string_view popWord(std::string_view &text, const std::string_view separators) {
+    const auto begin = text.find_first_not_of(separators);
+    if (begin == std::string_view::npos) {
+        text = {};
+        return {};
+    }
+    text.remove_prefix(begin);
+
+    const auto word = text.substr(0, text.find_first_of(separators));
+    text.remove_prefix(word.size());
+    return word;
+}
+
+/**
+ * @return  false after printing the error, if an annotation is invalid.
+ */
+[[nodiscard]]
+bool parseAnnotations(std::string_view preamble, const std::size_t line,
+                      Annotations &annotations) {
+    while (not preamble.empty()) {
+        auto a_line = preamble.substr(0, preamble.find('\n'));
+        preamble.remove_prefix(std::min(preamble.size(), a_line.size() + 1));
+
+        // Line comments may follow block comments.
+        const auto comment_begin = a_line.find("--");
+        if (comment_begin == std::string_view::npos) {
+            continue;
+        }
+        a_line.remove_prefix(comment_begin + 2);
+        a_line.remove_prefix(std::min(a_line.size(), a_line.find_first_not_of(WHITESPACES)));
+        if (not StartsWith(a_line, ANNOTATION_PREFIX)) {
+            continue;
+        }
+        a_line.remove_prefix(ANNOTATION_PREFIX.size());
+
+        for (auto word = popWord(a_line, WHITESPACES); not word.empty();
+             word = popWord(a_line, WHITESPACES)) {
+            if (word == "barrier") {
+                annotations.barrier = true;
+            } else if (StartsWith(word, "id=") and word.size() > 3) {
+                annotations.id = word.substr(3);
+            } else if (StartsWith(word, "after=")) {
+                word.remove_prefix(6);
+                for (auto name = popWord(word, ","); not name.empty(); name = popWord(word, ",")) {
+                    annotations.after.push_back(name);
+                }
+            } else {
+                std::cerr << "Line " << line << ": Invalid psqlxx annotation '" << word <<
+                          "'." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+
+namespace psqlxx {
+
+std::optional<std::vector<ScriptTask>> PlanScript(const std::string_view script) {
+    std::vector<ScriptTask> tasks;
+    std::unordered_map<std::string_view, std::size_t> named_tasks;
+
+    // Later tasks depend on the last barrier, which depends on all tasks before it.
+    std::optional<std::size_t> last_barrier;
+    std::vector<std::size_t> tasks_since_barrier;
+    const auto add_barrier = [&tasks, &last_barrier, &tasks_since_barrier](
+    const std::string_view text, const std::size_t line) {
+        ScriptTask barrier{text, line, std::move(tasks_since_barrier)};
+        if (barrier.dependencies.empty() and last_barrier) {
+            barrier.dependencies.push_back(*last_barrier);
+        }
+        last_barrier = tasks.size();
+        tasks.push_back(std::move(barrier));
+        tasks_since_barrier.clear();
+    };
+
+    SqlSplitter splitter{script};
+    while (const auto a_statement = splitter.Next()) {
+        Annotations annotations;
+        if (not parseAnnotations(a_statement->preamble, a_statement->line, annotations)) {
+            return {};
+        }
+
+        if (annotations.barrier) {
+            add_barrier({}, a_statement->line);
+        }
+        if (IsCommandLine(a_statement->text)) {
+            add_barrier(a_statement->text, a_statement->line);
+            continue;
+        }
+
+        ScriptTask a_task{a_statement->text, a_statement->line, {}};
+        if (last_barrier) {
+            a_task.dependencies.push_back(*last_barrier);
+        }
+        for (const auto name : annotations.after) {
+            const auto named_iter = named_tasks.find(name);
+            if (named_iter == named_tasks.cend()) {
+                std::cerr << "Line " << a_statement->line << ": Unknown statement id '" <<
+                          name << "', which must be defined earlier." << std::endl;
+                return {};
+            }
+            a_task.dependencies.push_back(named_iter->second);
+        }
+
+        if (not annotations.id.empty() and
+            not named_tasks.emplace(annotations.id, tasks.size()).second) {
+            std::cerr << "Line " << a_statement->line << ": Duplicate statement id '" <<
+                      annotations.id << "'." << std::endl;
+            return {};
+        }
+
+        tasks_since_barrier.push_back(tasks.size());
+        tasks.push_back(std::move(a_task));
+    }
+
+    return tasks;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+namespace psqlxx {
+
+struct ScriptTask {
+    // The statement, or empty for a barrier
+    std::string_view text;
+
+    std::size_t line = 0;
+
+    // Earlier tasks which must complete first
+    std::vector<std::size_t> dependencies;
+};
+
+/**
+ * Plans the statements of a script for parallel execution. They are independent, unless
+ * ordered by annotations in the line comments before them:
+ *
+ *      -- psqlxx: id=NAME              names the statement
+ *      -- psqlxx: after=NAME[,NAME]    runs it after the named statements
+ *      -- psqlxx: barrier              runs it, and all later ones, after all earlier ones
+ *
+ * Command lines, such as psqlxx commands, act as barriers.
+ *
+ * @return  nullopt after printing the error, if an annotation is invalid.
+ */
+[[nodiscard]]
+std::optional<std::vector<ScriptTask>> PlanScript(const std::string_view script);
+
+}//namespace psqlxx
@@ -0,0 +1,68 @@
+#include <psqlxx/script_plan.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using Dependencies = std::vector<std::size_t>;
+
+[[nodiscard]]
+auto getDependencies(const std::string_view script) {
+    std::vector<Dependencies> dependencies;
+    const auto tasks = PlanScript(script);
+    EXPECT_TRUE(tasks);
+    if (tasks) {
+        for (const auto &a_task : *tasks) {
+            dependencies.push_back(a_task.dependencies);
+        }
+    }
+    return dependencies;
+}
+
+}
+
+
+TEST(PlanScriptTests, ReturnIndependentTasksIfGivenNoAnnotations) {
+    const auto tasks = PlanScript("select 1; -- a comment\nselect 2;");
+    ASSERT_TRUE(tasks);
+    ASSERT_EQ(2u, tasks->size());
+    ASSERT_EQ("select 2", tasks->back().text);
+    ASSERT_EQ(2u, tasks->back().line);
+
+    const std::vector<Dependencies> expected{{}, {}};
+    ASSERT_EQ(expected, getDependencies("select 1; -- a comment\nselect 2;"));
+}
+
+TEST(PlanScriptTests, CanOrderByNamedDependencies) {
+    const std::vector<Dependencies> expected{{}, {}, {0, 1}, {0}};
+    ASSERT_EQ(expected, getDependencies("-- psqlxx: id=a\ncreate table a();\n"
+                                        "--psqlxx:id=b\ncreate table b();\n"
+                                        "-- psqlxx: after=a,b\nselect 1;\n"
+                                        "/* c */ -- psqlxx: after=a\nselect 2;\n"));
+}
+
+TEST(PlanScriptTests, CanOrderByBarriers) {
+    const std::vector<Dependencies> expected{{}, {}, {0, 1}, {2}, {2}, {3, 4}, {5}};
+    ASSERT_EQ(expected, getDependencies("select 1; select 2;\n"
+                                        "-- psqlxx: barrier\nselect 3; select 4;\n"
+                                        "-- psqlxx: barrier\nselect 5;"));
+}
+
+TEST(PlanScriptTests, CanTreatPsqlxxCommandsAsBarriers) {
+    const auto tasks = PlanScript("select 1;\n@l\nselect 2;");
+    ASSERT_TRUE(tasks);
+    ASSERT_EQ("@l", (*tasks)[1].text);
+
+    const std::vector<Dependencies> expected{{}, {0}, {1}};
+    ASSERT_EQ(expected, getDependencies("select 1;\n@l\nselect 2;"));
+}
+
+TEST(PlanScriptTests, ReturnNulloptIfGivenInvalidAnnotations) {
+    ASSERT_FALSE(PlanScript("-- psqlxx: after=a\nselect 1;"));
+    ASSERT_FALSE(PlanScript("-- psqlxx: id=a\nselect 1;\n-- psqlxx: id=a\nselect 2;"));
+    ASSERT_FALSE(PlanScript("-- psqlxx: unknown\nselect 1;"));
+}
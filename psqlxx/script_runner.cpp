@@ -0,0 +1,285 @@
+#include <psqlxx/script_runner.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <psqlxx/command.hpp>
+#include <psqlxx/db.hpp>
+#include <psqlxx/mapped_file.hpp>
+#include <psqlxx/script_plan.hpp>
+#include <psqlxx/session_state.hpp>
+#include <psqlxx/sql_splitter.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr std::string_view WHITESPACES = " \t\n\r\f\v";
+
+/**
+ * Adds the builtin commands of the prompt which make sense in a script, and the psqlxx ones.
+ */
+void addCommandGroups(std::vector<CommandGroup> &command_groups, const DbProxy &proxy) {
+    CommandGroup builtin_group{"builtin", "quit, exit and help"};
+    builtin_group.AddOptions()
+    ({"quit", "exit", "@q"}, {}, &Quit, "To quit")
+    ({"help"}, {"[GROUP]"}, [&command_groups](const auto words, const auto word_count) {
+        return word_count == 2 ? HelpGroups(command_groups, words[1]) : HelpGroups(command_groups);
+    }, "Print help summary or for an individual group")
+    ;
+
+    command_groups.push_back(std::move(builtin_group));
+    command_groups.push_back(CreatePsqlxxCommandGroup(proxy));
+}
+
+/**
+ * Runs a command line, split into words at whitespaces, through the first of command_groups
+ * which knows it, as the prompt does.
+ */
+[[nodiscard]]
+CommandResult runCommandLine(const std::vector<CommandGroup> &command_groups,
+                             std::string_view command_line) {
+    std::vector<std::string> words;
+    for (auto begin = command_line.find_first_not_of(WHITESPACES);
+         begin != std::string_view::npos;
+         begin = command_line.find_first_not_of(WHITESPACES)) {
+        command_line.remove_prefix(begin);
+        words.emplace_back(command_line.substr(0, command_line.find_first_of(WHITESPACES)));
+        command_line.remove_prefix(words.back().size());
+    }
+
+    std::vector<const char *> word_pointers;
+    word_pointers.reserve(words.size());
+    for (const auto &a_word : words) {
+        word_pointers.push_back(a_word.c_str());
+    }
+
+    for (const auto &a_group : command_groups) {
+        const auto result = a_group(word_pointers.data(), word_pointers.size());
+        if (result != CommandResult::unknown) {
+            return result;
+        }
+    }
+
+    return CommandResult::unknown;
+}
+
+/**
+ * Runs statements one after another, pipelined or in batches if so configured. If
+ * stop_at_failure, no statement runs after the first which failed, as for -c without them.
+ *
+ * @note    Statements must outlive the runner, or its next Finish().
+ */
+class StatementRunner {
+    const DbProxy &m_proxy;
+    std::vector<CommandGroup> m_command_groups;
+    const std::size_t m_batch_size;
+    const bool m_stop_at_failure;
+
+    std::vector<std::string> m_pipelined_statements;
+    std::vector<std::string_view> m_batch;
+    bool m_last_succeeded = true;
+    bool m_all_succeeded = true;
+
+    void setResult(const bool succeeded) {
+        m_last_succeeded = succeeded;
+        m_all_succeeded = succeeded and m_all_succeeded;
+    }
+
+    void flush() {
+        if (not m_pipelined_statements.empty()) {
+            setResult(m_proxy.RunPipeline(m_pipelined_statements));
+            m_pipelined_statements.clear();
+        }
+        if (not m_batch.empty()) {
+            setResult(m_proxy.DoBatch(m_batch, m_stop_at_failure));
+            m_batch.clear();
+        }
+    }
+
+public:
+    StatementRunner(const DbProxy &proxy, const bool stop_at_failure):
+        m_proxy(proxy),
+        m_batch_size(proxy.GetOptions().batch_size),
+        m_stop_at_failure(stop_at_failure) {
+        addCommandGroups(m_command_groups, proxy);
+    }
+    StatementRunner(const StatementRunner &) = delete;
+    StatementRunner &operator=(const StatementRunner &) = delete;
+
+    /**
+     * @return  false once no more statements are to run, after a command has quit, or a
+     *          failure if stop_at_failure.
+     */
+    [[nodiscard]]
+    bool Run(const std::string_view a_statement) {
+        if (IsCommandLine(a_statement)) {
+            flush();
+            const auto result = runCommandLine(m_command_groups, a_statement);
+            if (result == CommandResult::exit) {
+                return false;
+            }
+            setResult(result == CommandResult::success);
+        } else if (m_proxy.GetOptions().pipeline) {
+            // A pipeline takes single statements only, which a -c command may hold several of.
+            SqlSplitter splitter{a_statement};
+            while (const auto a_pipelined_statement = splitter.Next()) {
+                m_pipelined_statements.emplace_back(a_pipelined_statement->text);
+            }
+        } else if (m_batch_size > 1 and not IsTransactionControl(a_statement)) {
+            m_batch.push_back(a_statement);
+            if (m_batch.size() >= m_batch_size) {
+                flush();
+            }
+        } else {
+            // Transaction control statements end a batch, and run on their own.
+            flush();
+            setResult(m_proxy.DoTransaction(a_statement));
+        }
+
+        return m_all_succeeded or not m_stop_at_failure;
+    }
+
+    void Finish() {
+        flush();
+    }
+
+    /**
+     * Of the last statement, batch or pipeline, or command, as the prompt tells.
+     */
+    [[nodiscard]]
+    bool LastSucceeded() const {
+        return m_last_succeeded;
+    }
+
+    [[nodiscard]]
+    bool AllSucceeded() const {
+        return m_all_succeeded;
+    }
+};
+
+/**
+ * Runs the planned statements on DbProxyOptions::jobs connections. psqlxx commands run on
+ * the proxy, once the statements before them have completed.
+ */
+[[nodiscard]]
+bool runInParallel(const DbProxy &proxy, const std::vector<ScriptTask> &tasks) {
+    // Its replay could not keep the order the annotations give the statements.
+    if (not proxy.GetOptions().capture_file.empty()) {
+        std::cerr << "--capture cannot be used with --jobs." << std::endl;
+        return false;
+    }
+    for (const auto &a_task : tasks) {
+        if (IsTransactionControl(a_task.text)) {
+            std::cerr << "Line " << a_task.line <<
+                      ": Transaction control statements cannot run with --jobs." << std::endl;
+            return false;
+        }
+        // It would change the session of one worker connection only.
+        if (SessionState::IsChange(a_task.text)) {
+            std::cerr << "Line " << a_task.line <<
+                      ": Statements changing the session state cannot run with --jobs." <<
+                      std::endl;
+            return false;
+        }
+    }
+
+    std::vector<CommandGroup> command_groups;
+    addCommandGroups(command_groups, proxy);
+    auto last_succeeded = true;
+
+    std::vector<std::string_view> statements;
+    std::vector<std::vector<std::size_t>> dependencies;
+    const auto flush = [&proxy, &last_succeeded, &statements, &dependencies] {
+        if (not statements.empty()) {
+            last_succeeded = proxy.RunInParallel(statements, dependencies,
+                                                 proxy.GetOptions().jobs);
+            statements.clear();
+            dependencies.clear();
+        }
+    };
+
+    // The statements each task stands for in the current segment, which a barrier
+    // passes on from its dependencies; completed tasks stand for none.
+    std::vector<std::vector<std::size_t>> statements_of_tasks(tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        const auto &a_task = tasks[i];
+        std::vector<std::size_t> task_dependencies;
+        for (const auto a_dependency : a_task.dependencies) {
+            const auto &dependency_statements = statements_of_tasks[a_dependency];
+            task_dependencies.insert(task_dependencies.cend(), dependency_statements.cbegin(),
+                                     dependency_statements.cend());
+        }
+
+        if (a_task.text.empty()) {
+            statements_of_tasks[i] = std::move(task_dependencies);
+        } else if (IsCommandLine(a_task.text)) {
+            flush();
+            for (auto &completed_statements : statements_of_tasks) {
+                completed_statements.clear();
+            }
+            const auto result = runCommandLine(command_groups, a_task.text);
+            if (result == CommandResult::exit) {
+                return true;
+            }
+            last_succeeded = result == CommandResult::success;
+        } else {
+            statements_of_tasks[i] = {statements.size()};
+            statements.push_back(a_task.text);
+            dependencies.push_back(std::move(task_dependencies));
+        }
+    }
+    flush();
+
+    return last_succeeded;
+}
+
+}
+
+
+namespace psqlxx {
+
+bool RunScript(const DbProxy &proxy, const std::string_view script) {
+    if (proxy.GetOptions().jobs > 1) {
+        const auto tasks = PlanScript(script);
+        return tasks and runInParallel(proxy, *tasks);
+    }
+
+    StatementRunner runner{proxy, false};
+
+    SqlSplitter splitter{script};
+    while (const auto a_statement = splitter.Next()) {
+        if (not runner.Run(a_statement->text)) {
+            return true;
+        }
+    }
+
+    runner.Finish();
+    return runner.LastSucceeded();
+}
+
+bool RunCommandFile(const DbProxy &proxy, const std::string &command_file) {
+    const MappedFile file{command_file};
+    if (not file) {
+        return false;
+    }
+
+    return RunScript(proxy, file.View());
+}
+
+bool RunCommands(const DbProxy &proxy, const std::vector<std::string> &commands) {
+    StatementRunner runner{proxy, true};
+    for (const auto &a_command : commands) {
+        if (not a_command.empty() and not runner.Run(a_command)) {
+            return runner.AllSucceeded();
+        }
+    }
+
+    runner.Finish();
+    return runner.AllSucceeded();
+}
+
+}//namespace psqlxx
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace psqlxx {
+
+class DbProxy;
+
+
+/**
+ * Runs a script non-interactively. Statements are split by SqlSplitter and sent as they are,
+ * through a pipeline if DbProxyOptions::pipeline is set, or in transactions of
+ * DbProxyOptions::batch_size statements. Command lines run as at the prompt: '@' lines
+ * run psqlxx commands, and quit, exit and help are builtin.
+ *
+ * With DbProxyOptions::jobs above 1, statements run in parallel instead, ordered only by
+ * their annotations, as planned by PlanScript().
+ *
+ * @return  As the prompt, true once quit, or else whether the last statement, or batch,
+ *          pipeline or command, succeeded. A failed statement does not stop the script.
+ */
+[[nodiscard]]
+bool RunScript(const DbProxy &proxy, const std::string_view script);
+
+[[nodiscard]]
+bool RunCommandFile(const DbProxy &proxy, const std::string &command_file);
+
+/**
+ * Runs -c commands like the statements of a script, but stops at the first which fails.
+ *
+ * @return  true if every command succeeded.
+ */
+[[nodiscard]]
+bool RunCommands(const DbProxy &proxy, const std::vector<std::string> &commands);
+
+}//namespace psqlxx
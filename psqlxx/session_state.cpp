@@ -0,0 +1,169 @@
+#include <psqlxx/session_state.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include <psqlxx/string_utils.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+enum class ChangeKind {
+    none,
+    set,
+    reset,
+    reset_all_settings,
+    deallocate_all,
+    discard_all,
+};
+
+struct Change {
+    ChangeKind kind = ChangeKind::none;
+    // Like "set search_path" or "prepare foo"
+    std::string key;
+};
+
+inline constexpr std::string_view SETTING_PREFIX = "set ";
+inline constexpr std::string_view PREPARED_PREFIX = "prepare ";
+
+[[nodiscard]]
+inline auto is(const std::string_view keyword, const std::string_view expected) {
+    return EqualsIgnoreCase(keyword, expected);
+}
+
+[[nodiscard]]
+std::string makeKey(const std::string_view prefix, std::string_view name) {
+    // SET name=value may be written without spaces.
+    name = name.substr(0, name.find('='));
+
+    std::string key{prefix};
+    std::transform(name.cbegin(), name.cend(), std::back_inserter(key), [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return key;
+}
+
+/**
+ * @return  The setting named by the words after SET or RESET.
+ */
+[[nodiscard]]
+std::string_view popSettingName(std::string_view &sql_cmd) {
+    const auto name = PopKeyword(sql_cmd);
+    if (is(name, "session")) {
+        // SET SESSION AUTHORIZATION, SET SESSION CHARACTERISTICS or SET SESSION name
+        return PopKeyword(sql_cmd);
+    }
+    return name;
+}
+
+[[nodiscard]]
+Change getChange(std::string_view sql_cmd) {
+    const auto first_keyword = PopKeyword(sql_cmd);
+
+    if (is(first_keyword, "set")) {
+        const auto name = popSettingName(sql_cmd);
+        // Scoped to the transaction, rather than to the session
+        if (name.empty() or is(name, "local") or is(name, "transaction") or
+            is(name, "constraints")) {
+            return {};
+        }
+        return {ChangeKind::set, makeKey(SETTING_PREFIX, name)};
+    }
+
+    if (is(first_keyword, "reset")) {
+        const auto name = popSettingName(sql_cmd);
+        if (is(name, "all")) {
+            return {ChangeKind::reset_all_settings, {}};
+        }
+        return {ChangeKind::reset, makeKey(SETTING_PREFIX, name)};
+    }
+
+    if (is(first_keyword, "prepare")) {
+        const auto name = PopKeyword(sql_cmd);
+        // PREPARE TRANSACTION ends a transaction, for two-phase commit.
+        if (name.empty() or is(name, "transaction")) {
+            return {};
+        }
+        return {ChangeKind::set, makeKey(PREPARED_PREFIX, name)};
+    }
+
+    if (is(first_keyword, "deallocate")) {
+        auto name = PopKeyword(sql_cmd);
+        if (is(name, "prepare")) {
+            name = PopKeyword(sql_cmd);
+        }
+        if (is(name, "all")) {
+            return {ChangeKind::deallocate_all, {}};
+        }
+        return {ChangeKind::reset, makeKey(PREPARED_PREFIX, name)};
+    }
+
+    if (is(first_keyword, "discard") and is(PopKeyword(sql_cmd), "all")) {
+        return {ChangeKind::discard_all, {}};
+    }
+
+    return {};
+}
+
+}
+
+
+namespace psqlxx {
+
+bool SessionState::IsChange(const std::string_view sql_cmd) {
+    return getChange(sql_cmd).kind != ChangeKind::none;
+}
+
+void SessionState::erase(const std::string_view key) {
+    m_statements.erase(std::remove_if(m_statements.begin(), m_statements.end(),
+    [key](const auto & a_statement) {
+        return a_statement.first == key;
+    }), m_statements.end());
+}
+
+void SessionState::eraseAll(const std::string_view key_prefix) {
+    m_statements.erase(std::remove_if(m_statements.begin(), m_statements.end(),
+    [key_prefix](const auto & a_statement) {
+        return StartsWith(a_statement.first, key_prefix);
+    }), m_statements.end());
+}
+
+void SessionState::Record(const std::string_view sql_cmd) {
+    auto a_change = getChange(sql_cmd);
+    switch (a_change.kind) {
+        case ChangeKind::none:
+            break;
+        case ChangeKind::set:
+            // Moved to the end, after the statements it may depend on, like a search_path.
+            erase(a_change.key);
+            m_statements.emplace_back(std::move(a_change.key), sql_cmd);
+            break;
+        case ChangeKind::reset:
+            erase(a_change.key);
+            break;
+        case ChangeKind::reset_all_settings:
+            eraseAll(SETTING_PREFIX);
+            break;
+        case ChangeKind::deallocate_all:
+            eraseAll(PREPARED_PREFIX);
+            break;
+        case ChangeKind::discard_all:
+            Clear();
+            break;
+    }
+}
+
+std::vector<std::string_view> SessionState::Statements() const {
+    std::vector<std::string_view> statements;
+    statements.reserve(m_statements.size());
+    for (const auto &a_statement : m_statements) {
+        statements.push_back(a_statement.second);
+    }
+    return statements;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * The statements which have shaped the state of the session, such as SET, including
+ * search_path, and PREPARE, to re-apply to a new connection after the old one was lost.
+ * Only the last statement changing a setting or prepared statement is kept.
+ *
+ * @note    Settings changed through functions, such as set_config(), are not recorded.
+ */
+class SessionState {
+    // Keyed by the setting or prepared statement, in the order they were last changed
+    std::vector<std::pair<std::string, std::string>> m_statements;
+
+    void erase(const std::string_view key);
+    void eraseAll(const std::string_view key_prefix);
+
+public:
+    /**
+     * @return  true if sql_cmd sets, resets or discards session state.
+     */
+    [[nodiscard]]
+    static bool IsChange(std::string_view sql_cmd);
+
+    /**
+     * Records sql_cmd, which has taken effect in the session, if it changes its state.
+     */
+    void Record(std::string_view sql_cmd);
+
+    void Clear() {
+        m_statements.clear();
+    }
+
+    /**
+     * @return  The statements to run, in order, to restore the state.
+     */
+    [[nodiscard]]
+    std::vector<std::string_view> Statements() const;
+};
+
+}//namespace psqlxx
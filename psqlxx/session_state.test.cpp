@@ -0,0 +1,86 @@
+#include <psqlxx/session_state.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+using Statements = std::vector<std::string_view>;
+
+}
+
+
+TEST(SessionStateTests, CanRecordSettingsAndPreparedStatements) {
+    SessionState state;
+    state.Record("SET search_path TO app, public");
+    state.Record("PREPARE get_user(int) AS SELECT * FROM users WHERE id = $1");
+    state.Record("SELECT 1");
+
+    ASSERT_EQ((Statements{"SET search_path TO app, public",
+                          "PREPARE get_user(int) AS SELECT * FROM users WHERE id = $1"}),
+              state.Statements());
+}
+
+TEST(SessionStateTests, KeepOnlyLastChangeOfSetting) {
+    SessionState state;
+    state.Record("set work_mem = '64MB'");
+    state.Record("SET statement_timeout=0");
+    state.Record("SET SESSION Work_Mem TO '128MB'");
+
+    ASSERT_EQ((Statements{"SET statement_timeout=0", "SET SESSION Work_Mem TO '128MB'"}),
+              state.Statements());
+}
+
+TEST(SessionStateTests, IgnoreTransactionScopedSettings) {
+    SessionState state;
+    state.Record("SET LOCAL work_mem = '64MB'");
+    state.Record("SET TRANSACTION ISOLATION LEVEL SERIALIZABLE");
+    state.Record("SET CONSTRAINTS ALL DEFERRED");
+    state.Record("PREPARE TRANSACTION 'foo'");
+
+    ASSERT_TRUE(state.Statements().empty());
+    ASSERT_FALSE(SessionState::IsChange("SET LOCAL work_mem = '64MB'"));
+    ASSERT_TRUE(SessionState::IsChange("set role admin"));
+}
+
+TEST(SessionStateTests, CanForgetResetSettings) {
+    SessionState state;
+    state.Record("SET work_mem = '64MB'");
+    state.Record("SET search_path = app");
+    state.Record("PREPARE foo AS SELECT 1");
+    state.Record("RESET work_mem");
+
+    ASSERT_EQ((Statements{"SET search_path = app", "PREPARE foo AS SELECT 1"}),
+              state.Statements());
+
+    state.Record("RESET ALL");
+    ASSERT_EQ((Statements{"PREPARE foo AS SELECT 1"}), state.Statements());
+}
+
+TEST(SessionStateTests, CanForgetDeallocatedStatements) {
+    SessionState state;
+    state.Record("PREPARE foo AS SELECT 1");
+    state.Record("PREPARE bar AS SELECT 2");
+    state.Record("SET search_path = app");
+    state.Record("DEALLOCATE PREPARE foo");
+
+    ASSERT_EQ((Statements{"PREPARE bar AS SELECT 2", "SET search_path = app"}),
+              state.Statements());
+
+    state.Record("DEALLOCATE ALL");
+    ASSERT_EQ((Statements{"SET search_path = app"}), state.Statements());
+}
+
+TEST(SessionStateTests, CanForgetAllOnDiscardAll) {
+    SessionState state;
+    state.Record("SET search_path = app");
+    state.Record("PREPARE foo AS SELECT 1");
+    state.Record("DISCARD PLANS");
+    ASSERT_EQ(2u, state.Statements().size());
+
+    state.Record("discard all;");
+    ASSERT_TRUE(state.Statements().empty());
+}
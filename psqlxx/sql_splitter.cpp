@@ -0,0 +1,210 @@
+#include <psqlxx/sql_splitter.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr std::string_view WHITESPACES = " \t\n\r\f\v";
+
+// Characters which may start a quote or a comment, or end a statement
+constexpr std::string_view SPECIAL_CHARS = "'\"$-/;()";
+
+[[nodiscard]]
+inline bool isIdentifierChar(const char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) or c == '_' or
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+[[nodiscard]]
+inline bool startsWith(const std::string_view script, const std::size_t position,
+                       const std::string_view prefix) {
+    return script.compare(position, prefix.size(), prefix) == 0;
+}
+
+/**
+ * @return  The position after the quoted string or identifier which starts at position.
+ */
+[[nodiscard]]
+std::size_t skipQuoted(const std::string_view script, std::size_t position,
+                       const bool backslash_escapes) {
+    const auto quote = script[position++];
+    const char stops[] = {quote, backslash_escapes ? '\\' : quote, '\0'};
+
+    while ((position = script.find_first_of(stops, position)) != std::string_view::npos) {
+        if (script[position] == '\\') {
+            position += 2;
+        } else if (position + 1 < script.size() and script[position + 1] == quote) {
+            position += 2;
+        } else {
+            return position + 1;
+        }
+    }
+
+    return script.size();
+}
+
+/**
+ * @return  The length of the dollar quote tag, such as "$$" or "$body$", which starts at
+ *          position; or 0 if there is none, e.g. for a "$1" parameter.
+ */
+[[nodiscard]]
+std::size_t getDollarTagLength(const std::string_view script, const std::size_t position) {
+    if (position > 0 and (isIdentifierChar(script[position - 1]) or script[position - 1] == '$')) {
+        return 0;
+    }
+
+    auto end = position + 1;
+    if (end < script.size() and std::isdigit(static_cast<unsigned char>(script[end]))) {
+        return 0;
+    }
+    while (end < script.size() and isIdentifierChar(script[end])) {
+        ++end;
+    }
+
+    return (end < script.size() and script[end] == '$') ? end + 1 - position : 0;
+}
+
+/**
+ * @return  The position after the block comment, which may nest, that starts at position.
+ */
+[[nodiscard]]
+std::size_t skipBlockComment(const std::string_view script, std::size_t position) {
+    std::size_t depth = 0;
+    do {
+        if (startsWith(script, position, "/*")) {
+            ++depth;
+            position += 2;
+        } else if (startsWith(script, position, "*/")) {
+            --depth;
+            position += 2;
+        } else {
+            ++position;
+        }
+    } while (depth > 0 and position < script.size());
+
+    return std::min(position, script.size());
+}
+
+[[nodiscard]]
+inline std::size_t skipLineComment(const std::string_view script, const std::size_t position) {
+    return std::min(script.find('\n', position), script.size());
+}
+
+[[nodiscard]]
+inline std::string_view trimEnd(const std::string_view text) {
+    return text.substr(0, text.find_last_not_of(WHITESPACES) + 1);
+}
+
+}
+
+
+namespace psqlxx {
+
+bool IsCommandLine(const std::string_view line) {
+    if (not line.empty() and line.front() == '@') {
+        return true;
+    }
+
+    const auto word_end = std::find_if_not(line.cbegin(), line.cend(), [](const char c) {
+        return std::isalpha(static_cast<unsigned char>(c));
+    });
+    if (word_end != line.cend() and WHITESPACES.find(*word_end) == std::string_view::npos) {
+        return false;
+    }
+
+    const auto first_word = line.substr(0, word_end - line.cbegin());
+    return first_word == "quit" or first_word == "exit" or first_word == "help";
+}
+
+void SqlSplitter::advanceTo(const std::size_t position) {
+    m_line += std::count(m_script.cbegin() + m_position, m_script.cbegin() + position, '\n');
+    m_position = position;
+}
+
+void SqlSplitter::skipSpacesAndComments() {
+    while (m_position < m_script.size()) {
+        if (WHITESPACES.find(m_script[m_position]) != std::string_view::npos) {
+            advanceTo(m_position + 1);
+        } else if (startsWith(m_script, m_position, "--")) {
+            advanceTo(skipLineComment(m_script, m_position));
+        } else if (startsWith(m_script, m_position, "/*")) {
+            advanceTo(skipBlockComment(m_script, m_position));
+        } else {
+            break;
+        }
+    }
+}
+
+std::optional<SqlStatement> SqlSplitter::scanStatement() {
+    const auto preamble_begin = m_position;
+    skipSpacesAndComments();
+    if (m_position >= m_script.size()) {
+        return {};
+    }
+
+    const auto begin = m_position;
+    const auto line = m_line;
+    const auto preamble = m_script.substr(preamble_begin, begin - preamble_begin);
+
+    if (IsCommandLine(m_script.substr(begin))) {
+        advanceTo(skipLineComment(m_script, begin));
+        return SqlStatement{trimEnd(m_script.substr(begin, m_position - begin)), line, preamble};
+    }
+
+    std::size_t parenthesis_depth = 0;
+    while (m_position < m_script.size()) {
+        const auto c = m_script[m_position];
+        if (c == '\'') {
+            const auto escaped = m_position > 0 and
+                                 (m_script[m_position - 1] == 'E' or m_script[m_position - 1] == 'e') and
+                                 (m_position < 2 or not isIdentifierChar(m_script[m_position - 2]));
+            advanceTo(skipQuoted(m_script, m_position, escaped));
+        } else if (c == '"') {
+            advanceTo(skipQuoted(m_script, m_position, false));
+        } else if (c == '$') {
+            const auto tag_length = getDollarTagLength(m_script, m_position);
+            if (tag_length == 0) {
+                advanceTo(m_position + 1);
+            } else {
+                const auto tag = m_script.substr(m_position, tag_length);
+                const auto close = m_script.find(tag, m_position + tag_length);
+                advanceTo(close == std::string_view::npos ? m_script.size() : close + tag_length);
+            }
+        } else if (startsWith(m_script, m_position, "--")) {
+            advanceTo(skipLineComment(m_script, m_position));
+        } else if (startsWith(m_script, m_position, "/*")) {
+            advanceTo(skipBlockComment(m_script, m_position));
+        } else if (c == ';' and parenthesis_depth == 0) {
+            const auto text = trimEnd(m_script.substr(begin, m_position - begin));
+            advanceTo(m_position + 1);
+            return SqlStatement{text, line, preamble};
+        } else {
+            if (c == '(') {
+                ++parenthesis_depth;
+            } else if (c == ')' and parenthesis_depth > 0) {
+                --parenthesis_depth;
+            }
+            advanceTo(std::min(m_script.find_first_of(SPECIAL_CHARS, m_position + 1),
+                               m_script.size()));
+        }
+    }
+
+    return SqlStatement{trimEnd(m_script.substr(begin)), line, preamble};
+}
+
+std::optional<SqlStatement> SqlSplitter::Next() {
+    auto a_statement = scanStatement();
+    // Skips empty statements, of a semicolon only, however many follow one another.
+    while (a_statement and a_statement->text.empty()) {
+        a_statement = scanStatement();
+    }
+    return a_statement;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+
+namespace psqlxx {
+
+struct SqlStatement {
+    // Without leading comments and the terminating semicolon
+    std::string_view text;
+
+    // 1-based line of the statement's first character
+    std::size_t line = 0;
+
+    // Whitespaces and comments between the previous statement and this one
+    std::string_view preamble;
+};
+
+/**
+ * @return  Whether line is a command rather than SQL: a psqlxx command, which starts with
+ *          '@', or one of the builtin commands quit, exit and help.
+ */
+[[nodiscard]]
+bool IsCommandLine(const std::string_view line);
+
+/**
+ * Splits a script into statements at semicolons, as psql does: semicolons in quoted strings,
+ * quoted identifiers, dollar quotes, comments and parentheses do not end a statement.
+ * A command, as told by IsCommandLine(), is a statement of one line.
+ */
+class SqlSplitter {
+    std::string_view m_script;
+    std::size_t m_position = 0;
+    std::size_t m_line = 1;
+
+    void advanceTo(const std::size_t position);
+    void skipSpacesAndComments();
+
+    /**
+     * @return  The next statement, with empty text if a semicolon alone ended it, or nullopt
+     *          at the end of the script.
+     */
+    [[nodiscard]]
+    std::optional<SqlStatement> scanStatement();
+
+public:
+    explicit SqlSplitter(const std::string_view script): m_script(script) {
+    }
+
+    /**
+     * @return  The next statement, or nullopt at the end of the script.
+     */
+    [[nodiscard]]
+    std::optional<SqlStatement> Next();
+};
+
+}//namespace psqlxx
@@ -0,0 +1,119 @@
+#include <psqlxx/sql_splitter.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+auto split(const std::string_view script) {
+    std::vector<std::string_view> statements;
+    SqlSplitter splitter{script};
+    while (const auto a_statement = splitter.Next()) {
+        statements.push_back(a_statement->text);
+    }
+    return statements;
+}
+
+}
+
+
+TEST(SqlSplitterTests, ReturnNothingIfGivenOnlySpacesAndComments) {
+    ASSERT_TRUE(split("").empty());
+    ASSERT_TRUE(split(" \n-- comment\n/* block */ ;\n;").empty());
+}
+
+TEST(SqlSplitterTests, CanSkipManyEmptyStatements) {
+    const std::vector<std::string_view> expected{"select 1"};
+    ASSERT_EQ(expected, split(std::string(100000, ';') + "select 1"));
+}
+
+TEST(SqlSplitterTests, CanSplitAtSemicolons) {
+    const std::vector<std::string_view> expected{"select 1", "select 2", "select 3"};
+    ASSERT_EQ(expected, split("select 1;\nselect 2 ;select 3\n"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInStrings) {
+    const std::vector<std::string_view> expected{"select 'a;''b'", "select 2"};
+    ASSERT_EQ(expected, split("select 'a;''b'; select 2"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInEscapeStrings) {
+    const std::vector<std::string_view> expected{R"(select E'a\';b')", "select 2"};
+    ASSERT_EQ(expected, split(R"(select E'a\';b'; select 2)"));
+}
+
+TEST(SqlSplitterTests, CanTreatBackslashesLiterallyInStandardStrings) {
+    const std::vector<std::string_view> expected{R"(select 'a\')", "select 2"};
+    ASSERT_EQ(expected, split(R"(select 'a\'; select 2)"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInQuotedIdentifiers) {
+    const std::vector<std::string_view> expected{R"(select 1 as "a;""b")", "select 2"};
+    ASSERT_EQ(expected, split(R"(select 1 as "a;""b"; select 2)"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInDollarQuotes) {
+    const std::string_view function = "create function f() returns int as $body$\n"
+                                      "begin return 1; end; $$ $b$\n"
+                                      "$body$ language plpgsql";
+    const std::vector<std::string_view> expected{function, "select $$;$$"};
+    ASSERT_EQ(expected, split(std::string{function} + ";\nselect $$;$$;"));
+}
+
+TEST(SqlSplitterTests, CanTellParametersFromDollarQuotes) {
+    const std::vector<std::string_view> expected{"prepare q as select $1", "select a$b$"};
+    ASSERT_EQ(expected, split("prepare q as select $1; select a$b$;"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInComments) {
+    const std::vector<std::string_view> expected{"select 1 -- a;\n+ /* b; /* c; */ d; */ 1"};
+    ASSERT_EQ(expected, split("select 1 -- a;\n+ /* b; /* c; */ d; */ 1;"));
+}
+
+TEST(SqlSplitterTests, CanIgnoreSemicolonsInParentheses) {
+    const std::vector<std::string_view> expected{
+        "create rule r as on insert to t do also (insert into u values (1); notify t)"};
+    ASSERT_EQ(expected, split(std::string{expected.front()} + ";"));
+}
+
+TEST(SqlSplitterTests, CanSplitPsqlxxCommandsAtLineEnds) {
+    const std::vector<std::string_view> expected{"@l", "select 1", "@copyout csv select 2; x"};
+    ASSERT_EQ(expected, split("  @l  \nselect 1; @copyout csv select 2; x\n"));
+}
+
+TEST(SqlSplitterTests, CanSplitBuiltinCommandsAtLineEnds) {
+    const std::vector<std::string_view> expected{"help psqlxx", "select 1", "quit"};
+    ASSERT_EQ(expected, split("help psqlxx\nselect 1; quit\n"));
+}
+
+TEST(SqlSplitterTests, CanTellCommandLines) {
+    ASSERT_TRUE(IsCommandLine("@q"));
+    ASSERT_TRUE(IsCommandLine("help"));
+    ASSERT_TRUE(IsCommandLine("exit"));
+    ASSERT_FALSE(IsCommandLine("quitting"));
+    ASSERT_FALSE(IsCommandLine("select 1"));
+}
+
+TEST(SqlSplitterTests, CanTrackLines) {
+    SqlSplitter splitter{"-- a\n\nselect\n1; /*\n*/ select 'x\ny';\n\nselect 3"};
+    std::vector<std::size_t> lines;
+    while (const auto a_statement = splitter.Next()) {
+        lines.push_back(a_statement->line);
+    }
+
+    const std::vector<std::size_t> expected{3, 5, 8};
+    ASSERT_EQ(expected, lines);
+}
+
+TEST(SqlSplitterTests, CanKeepCommentsBeforeStatements) {
+    SqlSplitter splitter{"select 1; -- a\n/* b */\nselect 2;"};
+    ASSERT_EQ("", splitter.Next()->preamble);
+    ASSERT_EQ(" -- a\n/* b */\n", splitter.Next()->preamble);
+}
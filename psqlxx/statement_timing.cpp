@@ -0,0 +1,97 @@
+#include <psqlxx/statement_timing.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+inline double toMilliseconds(const StatementTiming::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+[[nodiscard]]
+inline double toMilliseconds(const LatencyHistogram::ValueType microseconds) {
+    return microseconds / 1000.0;
+}
+
+void printPhases(std::ostream &out, const StatementTiming &timing) {
+    out << "wait " << toMilliseconds(timing.wait) << " ms, transfer " <<
+        toMilliseconds(timing.transfer) << " ms, format " << toMilliseconds(timing.format) <<
+        " ms, write " << toMilliseconds(timing.write) << " ms";
+}
+
+void printBytes(std::ostream &out, const std::size_t bytes) {
+    constexpr const char *UNITS[] = {"bytes", "kB", "MB", "GB", "TB"};
+
+    auto value = static_cast<double>(bytes);
+    std::size_t unit = 0;
+    for (; value >= 1024 and unit + 1 < std::size(UNITS); ++unit) {
+        value /= 1024;
+    }
+    out << std::setprecision(unit ? 1 : 0) << value << ' ' << UNITS[unit] << std::setprecision(3);
+}
+
+}
+
+
+namespace psqlxx {
+
+std::string FormatStatementTiming(const StatementTiming &timing) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) <<
+        "Time: " << toMilliseconds(timing.total) << " ms (";
+    printPhases(out, timing);
+    out << "), result ";
+    printBytes(out, timing.result_bytes);
+    return out.str();
+}
+
+void SessionStats::Add(const StatementTiming &timing, const bool succeeded) {
+    ++m_statement_count;
+    if (not succeeded) {
+        ++m_failed_count;
+    }
+
+    m_sums.total += timing.total;
+    m_sums.wait += timing.wait;
+    m_sums.transfer += timing.transfer;
+    m_sums.format += timing.format;
+    m_sums.write += timing.write;
+    m_sums.result_bytes += timing.result_bytes;
+    m_peak_result_bytes = std::max(m_peak_result_bytes, timing.result_bytes);
+
+    m_latencies.Record(
+        std::chrono::duration_cast<std::chrono::microseconds>(timing.total).count());
+}
+
+void SessionStats::Print(std::ostream &out) const {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+
+    out << std::fixed << std::setprecision(3) <<
+        "statements: " << m_statement_count << ", " << m_failed_count << " failed\n" <<
+        "total time: " << toMilliseconds(m_sums.total) << " ms (";
+    printPhases(out, m_sums);
+    out << ")\n" <<
+        "latency average: " << m_latencies.Mean() / 1000 << " ms, p50: " <<
+        toMilliseconds(m_latencies.ValueAtPercentile(50)) << " ms, p95: " <<
+        toMilliseconds(m_latencies.ValueAtPercentile(95)) << " ms, p99: " <<
+        toMilliseconds(m_latencies.ValueAtPercentile(99)) << " ms, max: " <<
+        toMilliseconds(m_latencies.Max()) << " ms\n" <<
+        "result memory peak: ";
+    printBytes(out, m_peak_result_bytes);
+    out << ", total: ";
+    printBytes(out, m_sums.result_bytes);
+    out << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}//namespace psqlxx
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+#include <psqlxx/latency_histogram.hpp>
+
+
+namespace psqlxx {
+
+/**
+ * Where the time of one statement went. Phases may overlap, e.g. when fetching in batches
+ * while earlier batches are formatted, so they need not add up to the total.
+ */
+struct StatementTiming {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration total{};
+    // Sending, server execution and network until the first rows arrive
+    Clock::duration wait{};
+    // Receiving the rest of the result
+    Clock::duration transfer{};
+    // Formatting the result, excluding writing it
+    Clock::duration format{};
+    // Writing the formatted result to the output
+    Clock::duration write{};
+
+    // Peak size of the result held in memory, counted only while timing is printed
+    std::size_t result_bytes = 0;
+};
+
+/**
+ * Adds the time from its construction to its destruction to a phase.
+ */
+class PhaseTimer {
+    StatementTiming::Clock::duration &m_phase;
+    const StatementTiming::Clock::time_point m_start = StatementTiming::Clock::now();
+
+public:
+    explicit PhaseTimer(StatementTiming::Clock::duration &phase): m_phase(phase) {
+    }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    ~PhaseTimer() {
+        m_phase += StatementTiming::Clock::now() - m_start;
+    }
+};
+
+[[nodiscard]]
+std::string FormatStatementTiming(const StatementTiming &timing);
+
+
+/**
+ * Aggregates the timings of a session.
+ */
+class SessionStats {
+    std::size_t m_statement_count = 0;
+    std::size_t m_failed_count = 0;
+
+    StatementTiming m_sums;
+    std::size_t m_peak_result_bytes = 0;
+    // Of the total times, in microseconds
+    LatencyHistogram m_latencies;
+
+public:
+    void Add(const StatementTiming &timing, const bool succeeded);
+
+    void Print(std::ostream &out) const;
+};
+
+}//namespace psqlxx
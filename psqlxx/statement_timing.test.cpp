@@ -0,0 +1,55 @@
+#include <psqlxx/statement_timing.hpp>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+using namespace std::chrono_literals;
+
+
+TEST(FormatStatementTimingTests, CanFormatPhases) {
+    StatementTiming timing;
+    timing.total = 12345us;
+    timing.wait = 10ms;
+    timing.transfer = 1ms;
+    timing.format = 1200us;
+    timing.write = 145us;
+    timing.result_bytes = 1536;
+
+    ASSERT_EQ("Time: 12.345 ms (wait 10.000 ms, transfer 1.000 ms, format 1.200 ms, "
+              "write 0.145 ms), result 1.5 kB", FormatStatementTiming(timing));
+
+    timing.result_bytes = 100;
+    ASSERT_NE(std::string::npos, FormatStatementTiming(timing).find("result 100 bytes"));
+}
+
+TEST(PhaseTimerTests, CanAddToPhase) {
+    StatementTiming::Clock::duration phase = 1h;
+    {
+        PhaseTimer timer{phase};
+    }
+    ASSERT_LE(1h, phase);
+    ASSERT_GT(1h + 1s, phase);
+}
+
+TEST(SessionStatsTests, CanAggregateTimings) {
+    SessionStats stats;
+    StatementTiming timing;
+    timing.total = 2ms;
+    timing.wait = 1ms;
+    timing.result_bytes = 2048;
+    stats.Add(timing, true);
+    timing.total = 4ms;
+    timing.result_bytes = 1024;
+    stats.Add(timing, false);
+
+    std::ostringstream out;
+    stats.Print(out);
+    const auto report = out.str();
+    ASSERT_NE(std::string::npos, report.find("statements: 2, 1 failed\n"));
+    ASSERT_NE(std::string::npos, report.find("total time: 6.000 ms (wait 2.000 ms,"));
+    ASSERT_NE(std::string::npos, report.find("latency average: 3.000 ms, p50: 2.0"));
+    ASSERT_NE(std::string::npos, report.find("result memory peak: 2.0 kB, total: 3.0 kB"));
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -13,6 +15,35 @@ StartsWith(const std::string_view str, const std::string_view prefix) {
     return str.rfind(prefix, 0) == 0;
 }
 
+[[nodiscard]]
+static inline auto
+EqualsIgnoreCase(const std::string_view lhs, const std::string_view rhs) {
+    return std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(),
+    [](const unsigned char l, const unsigned char r) {
+        return std::tolower(l) == std::tolower(r);
+    });
+}
+
+/**
+ * Removes and returns the first word of sql_cmd.
+ */
+[[nodiscard]]
+static inline std::string_view
+PopKeyword(std::string_view &sql_cmd) {
+    constexpr std::string_view SEPARATORS = " \t\n\r\f\v;(";
+
+    const auto begin = sql_cmd.find_first_not_of(SEPARATORS);
+    if (begin == std::string_view::npos) {
+        sql_cmd = {};
+        return {};
+    }
+    sql_cmd.remove_prefix(begin);
+
+    const auto keyword = sql_cmd.substr(0, sql_cmd.find_first_of(SEPARATORS));
+    sql_cmd.remove_prefix(keyword.size());
+    return keyword;
+}
+
 
 class Joiner {
     char m_delimiter{};
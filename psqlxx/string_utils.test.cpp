@@ -31,6 +31,33 @@ TEST(StartsWithTests, ReturnFalseIfGiveWrongPrefix) {
 }
 
 
+TEST(EqualsIgnoreCaseTests, ReturnTrueIfGiveEmptyStrings) {
+    ASSERT_TRUE(EqualsIgnoreCase("", ""));
+}
+
+TEST(EqualsIgnoreCaseTests, ReturnTrueIfOnlyCasesDiffer) {
+    ASSERT_TRUE(EqualsIgnoreCase("SeLeCt", "select"));
+}
+
+TEST(EqualsIgnoreCaseTests, ReturnFalseIfGivePrefix) {
+    ASSERT_FALSE(EqualsIgnoreCase("sel", "select"));
+}
+
+
+TEST(PopKeywordTests, CanPopKeywordsInOrder) {
+    std::string_view sql_cmd = "  PREPARE\tfoo(int) AS SELECT $1;";
+    ASSERT_EQ("PREPARE", PopKeyword(sql_cmd));
+    ASSERT_EQ("foo", PopKeyword(sql_cmd));
+    ASSERT_EQ("int)", PopKeyword(sql_cmd));
+}
+
+TEST(PopKeywordTests, ReturnEmptyIfNoKeywordLeft) {
+    std::string_view sql_cmd = " ; ";
+    ASSERT_TRUE(PopKeyword(sql_cmd).empty());
+    ASSERT_TRUE(sql_cmd.empty());
+}
+
+
 TEST(SpaceJoinerTests, ReturnExpectedSpaces) {
     ASSERT_EQ(std::string::npos, PREFIX.find(' '));
     const auto result = SpaceJoiner(PREFIX, PREFIX);
@@ -0,0 +1,140 @@
+#include <psqlxx/task_graph.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+class ReadyQueue {
+    std::mutex m_mutex;
+    std::deque<std::size_t> m_tasks;
+
+public:
+    void Push(const std::size_t task) {
+        std::lock_guard lock{m_mutex};
+        m_tasks.push_back(task);
+    }
+
+    /**
+     * For the owning worker, which takes its newest task.
+     */
+    [[nodiscard]]
+    std::optional<std::size_t> PopNewest() {
+        std::lock_guard lock{m_mutex};
+        if (m_tasks.empty()) {
+            return {};
+        }
+        const auto task = m_tasks.back();
+        m_tasks.pop_back();
+        return task;
+    }
+
+    /**
+     * For other workers, which steal the oldest task.
+     */
+    [[nodiscard]]
+    std::optional<std::size_t> PopOldest() {
+        std::lock_guard lock{m_mutex};
+        if (m_tasks.empty()) {
+            return {};
+        }
+        const auto task = m_tasks.front();
+        m_tasks.pop_front();
+        return task;
+    }
+};
+
+}
+
+
+namespace psqlxx {
+
+void RunTaskGraph(const std::vector<std::vector<std::size_t>> &dependencies,
+                  const std::size_t worker_count,
+                  const std::function<void(std::size_t, std::size_t)> &run) {
+    const auto task_count = dependencies.size();
+    if (task_count == 0) {
+        return;
+    }
+
+    std::vector<std::vector<std::size_t>> dependents(task_count);
+    std::vector<std::atomic<std::size_t>> remaining_dependencies(task_count);
+    for (std::size_t i = 0; i < task_count; ++i) {
+        remaining_dependencies[i] = dependencies[i].size();
+        for (const auto a_dependency : dependencies[i]) {
+            dependents[a_dependency].push_back(i);
+        }
+    }
+
+    const auto workers = std::max<std::size_t>(worker_count, 1);
+    std::vector<ReadyQueue> queues(workers);
+    for (std::size_t i = 0, next_worker = 0; i < task_count; ++i) {
+        if (dependencies[i].empty()) {
+            queues[next_worker++ % workers].Push(i);
+        }
+    }
+
+    // Tasks only become ready when others complete, so idle workers wait for completions.
+    std::mutex completion_mutex;
+    std::condition_variable completion_condition;
+    std::size_t completed_count = 0;
+
+    const auto work = [&](const std::size_t worker) {
+        while (true) {
+            std::size_t seen_completed_count = 0;
+            {
+                std::lock_guard lock{completion_mutex};
+                seen_completed_count = completed_count;
+            }
+            if (seen_completed_count == task_count) {
+                return;
+            }
+
+            auto task = queues[worker].PopNewest();
+            for (std::size_t i = 1; i < workers and not task; ++i) {
+                task = queues[(worker + i) % workers].PopOldest();
+            }
+
+            if (not task) {
+                std::unique_lock lock{completion_mutex};
+                completion_condition.wait(lock, [&] {
+                    return completed_count != seen_completed_count;
+                });
+                continue;
+            }
+
+            run(worker, *task);
+
+            for (const auto a_dependent : dependents[*task]) {
+                if (--remaining_dependencies[a_dependent] == 0) {
+                    queues[worker].Push(a_dependent);
+                }
+            }
+            {
+                std::lock_guard lock{completion_mutex};
+                ++completed_count;
+            }
+            completion_condition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        threads.emplace_back(work, i);
+    }
+    for (auto &a_thread : threads) {
+        a_thread.join();
+    }
+}
+
+}//namespace psqlxx
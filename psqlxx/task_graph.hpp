@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * Runs the tasks of an acyclic dependency graph on worker_count threads.
+ *
+ * Each worker runs the tasks its own completions made ready, newest first, and steals
+ * the oldest ready tasks of other workers when it has none.
+ *
+ * @param   dependencies    for each task, the tasks which must complete before it runs.
+ * @param   run             called once per task as run(worker, task), on the worker's thread.
+ */
+void RunTaskGraph(const std::vector<std::vector<std::size_t>> &dependencies,
+                  const std::size_t worker_count,
+                  const std::function<void(std::size_t, std::size_t)> &run);
+
+}//namespace psqlxx
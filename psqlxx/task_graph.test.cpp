@@ -0,0 +1,82 @@
+#include <psqlxx/task_graph.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+/**
+ * @return  The order in which the tasks ran.
+ */
+[[nodiscard]]
+auto runInOrder(const std::vector<std::vector<std::size_t>> &dependencies,
+                const std::size_t worker_count) {
+    std::mutex order_mutex;
+    std::vector<std::size_t> order;
+    RunTaskGraph(dependencies, worker_count, [&order_mutex, &order](const auto, const auto task) {
+        std::lock_guard lock{order_mutex};
+        order.push_back(task);
+    });
+    return order;
+}
+
+[[nodiscard]]
+auto ranBefore(const std::vector<std::size_t> &order, const std::size_t first,
+               const std::size_t second) {
+    return std::find(order.cbegin(), order.cend(), first) <
+           std::find(order.cbegin(), order.cend(), second);
+}
+
+}
+
+
+TEST(RunTaskGraphTests, CanRunNothing) {
+    ASSERT_TRUE(runInOrder({}, 4).empty());
+}
+
+TEST(RunTaskGraphTests, CanRunEachTaskOnce) {
+    const std::vector<std::vector<std::size_t>> dependencies(1000);
+    auto order = runInOrder(dependencies, 4);
+    std::sort(order.begin(), order.end());
+
+    ASSERT_EQ(1000u, order.size());
+    ASSERT_EQ(order.cend(), std::adjacent_find(order.cbegin(), order.cend()));
+}
+
+TEST(RunTaskGraphTests, CanRunTasksAfterTheirDependencies) {
+    const std::vector<std::vector<std::size_t>> dependencies{{}, {0}, {0}, {1, 2}, {}, {3, 4}};
+    for (const std::size_t worker_count : {1, 2, 8}) {
+        const auto order = runInOrder(dependencies, worker_count);
+        ASSERT_EQ(dependencies.size(), order.size());
+        for (std::size_t i = 0; i < dependencies.size(); ++i) {
+            for (const auto a_dependency : dependencies[i]) {
+                ASSERT_TRUE(ranBefore(order, a_dependency, i));
+            }
+        }
+    }
+}
+
+TEST(RunTaskGraphTests, CanRunIndependentTasksOnSeveralWorkers) {
+    std::atomic<std::size_t> running{0};
+    std::atomic<std::size_t> max_running{0};
+    const std::vector<std::vector<std::size_t>> dependencies(64);
+    RunTaskGraph(dependencies, 4, [&running, &max_running](const auto, const auto) {
+        const auto now_running = ++running;
+        auto max = max_running.load();
+        while (now_running > max and not max_running.compare_exchange_weak(max, now_running)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --running;
+    });
+
+    ASSERT_GT(max_running.load(), 1u);
+}
@@ -0,0 +1,118 @@
+#include <psqlxx/trace.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+struct ThreadBuffer {
+    std::size_t thread_id = 0;
+    std::vector<internal::TraceEvent> events;
+};
+
+internal::TraceClock::time_point g_trace_begin;
+
+// Buffers outlive their threads, until the session writes them.
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+[[nodiscard]]
+ThreadBuffer &getThreadBuffer() {
+    if (not t_buffer) {
+        const std::lock_guard lock{g_buffers_mutex};
+        g_buffers.push_back(std::make_unique<ThreadBuffer>());
+        g_buffers.back()->thread_id = g_buffers.size();
+        t_buffer = g_buffers.back().get();
+    }
+    return *t_buffer;
+}
+
+void appendJsonString(std::string &out, const std::string_view text) {
+    out += '"';
+    for (const auto c : text) {
+        if (c == '"' or c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::atomic<bool> g_tracing{false};
+
+void recordSpan(const char *name, const TraceClock::time_point begin,
+                const TraceClock::time_point end) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    getThreadBuffer().events.push_back({name,
+                                        duration_cast<microseconds>(begin - g_trace_begin).count(),
+                                        duration_cast<microseconds>(end - begin).count()});
+}
+
+std::string formatTraceEvent(const TraceEvent &an_event, const std::size_t thread_id) {
+    std::string out = "{\"name\":";
+    appendJsonString(out, an_event.name);
+    out += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(thread_id) +
+           ",\"ts\":" + std::to_string(an_event.begin_us) +
+           ",\"dur\":" + std::to_string(an_event.duration_us) + '}';
+    return out;
+}
+
+}//namespace internal
+
+
+TraceSession::TraceSession(std::string path): m_path(std::move(path)) {
+    if (m_path.empty()) {
+        return;
+    }
+
+    g_trace_begin = internal::TraceClock::now();
+    internal::g_tracing.store(true, std::memory_order_release);
+}
+
+TraceSession::~TraceSession() {
+    if (m_path.empty()) {
+        return;
+    }
+    internal::g_tracing.store(false, std::memory_order_release);
+
+    std::ofstream out{m_path, std::ofstream::out};
+    if (not out) {
+        std::cerr << "Failed to open trace file '" << m_path << "': " << std::strerror(errno) <<
+                  std::endl;
+        return;
+    }
+
+    const std::lock_guard lock{g_buffers_mutex};
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto first = true;
+    for (auto &a_buffer : g_buffers) {
+        for (const auto &an_event : a_buffer->events) {
+            out << (first ? "\n" : ",\n") << internal::formatTraceEvent(an_event,
+                                                                       a_buffer->thread_id);
+            first = false;
+        }
+        a_buffer->events.clear();
+    }
+    out << "\n]}" << std::endl;
+}
+
+}//namespace psqlxx
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace psqlxx {
+
+namespace internal {
+
+using TraceClock = std::chrono::steady_clock;
+
+extern std::atomic<bool> g_tracing;
+
+struct TraceEvent {
+    // A string literal
+    const char *name;
+    std::int64_t begin_us;
+    std::int64_t duration_us;
+};
+
+void recordSpan(const char *name, const TraceClock::time_point begin,
+                const TraceClock::time_point end);
+
+[[nodiscard]]
+std::string formatTraceEvent(const TraceEvent &an_event, const std::size_t thread_id);
+
+}//namespace internal
+
+
+/**
+ * Records the time from its construction to its destruction as a span of the current
+ * TraceSession. If none is active, it costs an atomic load.
+ *
+ * @param   name    must be a string literal, or otherwise outlive the session.
+ */
+class TraceSpan {
+    const char *m_name = nullptr;
+    internal::TraceClock::time_point m_begin;
+
+public:
+    explicit TraceSpan(const char *name) {
+        if (internal::g_tracing.load(std::memory_order_acquire)) {
+            m_name = name;
+            m_begin = internal::TraceClock::now();
+        }
+    }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    ~TraceSpan() {
+        if (m_name) {
+            internal::recordSpan(m_name, m_begin, internal::TraceClock::now());
+        }
+    }
+};
+
+
+/**
+ * Traces the spans of all threads while it lives, then writes them to a file in the
+ * Chrome trace event format, which Perfetto and chrome://tracing load.
+ *
+ * Each thread records to a buffer of its own without locking, so all threads which
+ * record spans must have finished by the time the session ends.
+ *
+ * @note    Only one session may be active at a time.
+ */
+class TraceSession {
+    std::string m_path;
+
+public:
+    /**
+     * @param   path    empty to not trace.
+     */
+    explicit TraceSession(std::string path);
+    TraceSession(const TraceSession &) = delete;
+    TraceSession &operator=(const TraceSession &) = delete;
+    ~TraceSession();
+};
+
+}//namespace psqlxx
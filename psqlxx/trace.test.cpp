@@ -0,0 +1,66 @@
+#include <psqlxx/trace.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+[[nodiscard]]
+auto readFile(const std::string &path) {
+    std::ifstream in{path};
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+}
+
+
+TEST(FormatTraceEventTests, CanFormatCompleteEvent) {
+    ASSERT_EQ(R"({"name":"execute","ph":"X","pid":1,"tid":2,"ts":10,"dur":5})",
+              internal::formatTraceEvent({"execute", 10, 5}, 2));
+    ASSERT_EQ(R"({"name":"a\"b","ph":"X","pid":1,"tid":1,"ts":0,"dur":0})",
+              internal::formatTraceEvent({"a\"b", 0, 0}, 1));
+}
+
+TEST(TraceSessionTests, CanWriteSpansOfAllThreads) {
+    const std::string path = testing::TempDir() + "psqlxx_trace_test.json";
+    {
+        const TraceSession session{path};
+        const TraceSpan outer{"outer"};
+        std::thread{[] {
+            const TraceSpan inner{"inner"};
+        }}.join();
+    }
+
+    const auto trace = readFile(path);
+    ASSERT_EQ(0u, trace.find(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+    ASSERT_NE(std::string::npos, trace.find(R"({"name":"outer","ph":"X")"));
+    ASSERT_NE(std::string::npos, trace.find(R"({"name":"inner","ph":"X")"));
+    ASSERT_EQ(trace.size() - 4, trace.find("\n]}\n"));
+    std::remove(path.c_str());
+}
+
+TEST(TraceSessionTests, CanSkipSpansIfNotTracing) {
+    const std::string path = testing::TempDir() + "psqlxx_trace_test.json";
+    {
+        const TraceSession session{path};
+    }
+    {
+        const TraceSpan ignored{"ignored"};
+    }
+    {
+        const TraceSession session{path};
+    }
+
+    ASSERT_EQ(std::string::npos, readFile(path).find("ignored"));
+    std::remove(path.c_str());
+}
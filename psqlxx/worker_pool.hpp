@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace psqlxx {
+
+/**
+ * Threads which are started once and then run the tasks of one Run() after another,
+ * so that repeated rounds of parallel work do not pay for starting threads each time.
+ *
+ * @note    Run() is meant to be called from one thread at a time.
+ */
+class WorkerPool {
+public:
+    using Task = std::function<void(const std::size_t)>;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_task_ready;
+    std::condition_variable m_all_done;
+
+    // Of the current Run(), null between runs
+    const Task *m_task = nullptr;
+    std::size_t m_task_count = 0;
+    std::size_t m_next_task = 0;
+    std::size_t m_pending_count = 0;
+    // The first a task threw, which drops the tasks not yet taken
+    std::exception_ptr m_exception;
+    bool m_stopping = false;
+
+    std::vector<std::thread> m_threads;
+
+    /**
+     * Runs tasks of the current Run() until none is left to take.
+     */
+    void runTasks(std::unique_lock<std::mutex> &lock) {
+        while (m_task and m_next_task < m_task_count) {
+            const auto &a_task = *m_task;
+            const auto i = m_next_task++;
+            lock.unlock();
+            try {
+                a_task(i);
+                lock.lock();
+            } catch (...) {
+                lock.lock();
+                if (not m_exception) {
+                    m_exception = std::current_exception();
+                }
+                m_pending_count -= m_task_count - m_next_task;
+                m_next_task = m_task_count;
+            }
+            if (--m_pending_count == 0) {
+                m_all_done.notify_all();
+            }
+        }
+    }
+
+    void work() {
+        std::unique_lock lock{m_mutex};
+        while (true) {
+            m_task_ready.wait(lock, [this] {
+                return m_stopping or (m_task and m_next_task < m_task_count);
+            });
+            if (m_stopping) {
+                return;
+            }
+            runTasks(lock);
+        }
+    }
+
+public:
+    explicit WorkerPool(const std::size_t thread_count) {
+        m_threads.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            m_threads.emplace_back(&WorkerPool::work, this);
+        }
+    }
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool() {
+        {
+            const std::lock_guard lock{m_mutex};
+            m_stopping = true;
+        }
+        m_task_ready.notify_all();
+        for (auto &a_thread : m_threads) {
+            a_thread.join();
+        }
+    }
+
+    [[nodiscard]]
+    std::size_t ThreadCount() const {
+        return m_threads.size();
+    }
+
+    /**
+     * Calls a_task(i) for each i in [0, task_count), on the pool's threads and on the
+     * calling one, and returns once all calls have returned.
+     *
+     * @note    If a call throws, the calls not yet made are dropped, and the exception is
+     *          rethrown once the calls in progress have returned.
+     */
+    void Run(const std::size_t task_count, const Task &a_task) {
+        std::unique_lock lock{m_mutex};
+        m_task = &a_task;
+        m_task_count = task_count;
+        m_next_task = 0;
+        m_pending_count = task_count;
+        m_task_ready.notify_all();
+
+        runTasks(lock);
+        m_all_done.wait(lock, [this] {
+            return m_pending_count == 0;
+        });
+        m_task = nullptr;
+        if (m_exception) {
+            std::rethrow_exception(std::exchange(m_exception, nullptr));
+        }
+    }
+};
+
+}//namespace psqlxx
@@ -0,0 +1,66 @@
+#include <psqlxx/worker_pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(WorkerPoolTests, RunCallsEachTaskOnce) {
+    WorkerPool workers{3};
+    std::vector<std::atomic_int> calls(100);
+
+    workers.Run(calls.size(), [&calls](const auto i) {
+        ++calls[i];
+    });
+
+    for (const auto &a_call_count : calls) {
+        ASSERT_EQ(1, a_call_count);
+    }
+}
+
+TEST(WorkerPoolTests, CanRunManyTimes) {
+    WorkerPool workers{2};
+    std::atomic_int sum = 0;
+
+    for (int round = 0; round < 1000; ++round) {
+        workers.Run(4, [&sum](const auto i) {
+            sum += i;
+        });
+    }
+
+    ASSERT_EQ(6000, sum);
+}
+
+TEST(WorkerPoolTests, CanRunWithoutThreads) {
+    WorkerPool workers{0};
+    int sum = 0;
+
+    workers.Run(3, [&sum](const auto i) {
+        sum += i;
+    });
+
+    ASSERT_EQ(3, sum);
+}
+
+TEST(WorkerPoolTests, CanRunAgainAfterTaskThrew) {
+    WorkerPool workers{2};
+
+    for (int round = 0; round < 100; ++round) {
+        ASSERT_THROW(workers.Run(8, [](const auto i) {
+            if (i % 3 == 0) {
+                throw std::runtime_error{"failed"};
+            }
+        }), std::runtime_error);
+    }
+
+    std::atomic_int sum = 0;
+    workers.Run(4, [&sum](const auto i) {
+        sum += i;
+    });
+    ASSERT_EQ(6, sum);
+}
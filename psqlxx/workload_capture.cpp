@@ -0,0 +1,166 @@
+#include <psqlxx/workload_capture.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#include <psqlxx/mapped_file.hpp>
+
+
+using namespace psqlxx;
+
+
+namespace {
+
+constexpr char FIELD_SEPARATOR = '\t';
+
+void appendEscaped(std::string &out, const std::string_view sql) {
+    for (const auto c : sql) {
+        switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            default:
+                out += c;
+                break;
+        }
+    }
+}
+
+[[nodiscard]]
+std::optional<std::string> unescape(const std::string_view escaped) {
+    std::string sql;
+    sql.reserve(escaped.size());
+    for (std::size_t i = 0; i < escaped.size(); ++i) {
+        if (escaped[i] != '\\') {
+            sql += escaped[i];
+            continue;
+        }
+        if (++i == escaped.size()) {
+            return {};
+        }
+        switch (escaped[i]) {
+            case '\\':
+                sql += '\\';
+                break;
+            case 't':
+                sql += '\t';
+                break;
+            case 'n':
+                sql += '\n';
+                break;
+            case 'r':
+                sql += '\r';
+                break;
+            default:
+                return {};
+        }
+    }
+    return sql;
+}
+
+[[nodiscard]]
+bool popNumber(std::string_view &line, std::int64_t &number) {
+    const auto separator_position = line.find(FIELD_SEPARATOR);
+    if (separator_position == std::string_view::npos) {
+        return false;
+    }
+
+    const auto *const end = line.data() + separator_position;
+    const auto [parsed_end, error] = std::from_chars(line.data(), end, number);
+    line.remove_prefix(separator_position + 1);
+    return error == std::errc{} and parsed_end == end;
+}
+
+}
+
+
+namespace psqlxx {
+
+namespace internal {
+
+std::string formatCapturedStatement(const CapturedStatement &a_statement) {
+    auto line = std::to_string(a_statement.offset_us) + FIELD_SEPARATOR +
+                std::to_string(a_statement.duration_us) + FIELD_SEPARATOR +
+                std::to_string(a_statement.row_count) + FIELD_SEPARATOR;
+    appendEscaped(line, a_statement.sql);
+    return line;
+}
+
+std::optional<CapturedStatement> parseCapturedStatement(std::string_view line) {
+    CapturedStatement a_statement;
+    if (not popNumber(line, a_statement.offset_us) or
+        not popNumber(line, a_statement.duration_us) or
+        not popNumber(line, a_statement.row_count)) {
+        return {};
+    }
+
+    auto sql = unescape(line);
+    if (not sql) {
+        return {};
+    }
+    a_statement.sql = std::move(*sql);
+    return a_statement;
+}
+
+}//namespace internal
+
+
+WorkloadCapture::WorkloadCapture(const std::string &path): m_file(path, std::ofstream::out) {
+    if (not m_file) {
+        std::cerr << "Failed to open capture file '" << path << "': " << std::strerror(errno) <<
+                  std::endl;
+    }
+}
+
+void WorkloadCapture::Record(const std::string_view sql, const Clock::time_point start,
+                             const Clock::time_point end, const std::int64_t row_count) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    const CapturedStatement a_statement{duration_cast<microseconds>(start - m_begin).count(),
+                                        duration_cast<microseconds>(end - start).count(),
+                                        row_count, std::string{sql}};
+    // Flushed, so that the capture survives the session being killed.
+    m_file << internal::formatCapturedStatement(a_statement) << std::endl;
+}
+
+std::optional<std::vector<CapturedStatement>> ReadCapture(const std::string &path) {
+    const MappedFile file{path};
+    if (not file) {
+        return {};
+    }
+
+    std::vector<CapturedStatement> statements;
+    auto data = file.View();
+    for (std::size_t line_number = 1; not data.empty(); ++line_number) {
+        const auto line = data.substr(0, data.find('\n'));
+        data.remove_prefix(std::min(data.size(), line.size() + 1));
+        if (line.empty()) {
+            continue;
+        }
+
+        auto a_statement = internal::parseCapturedStatement(line);
+        if (not a_statement) {
+            std::cerr << path << ':' << line_number << ": Invalid captured statement." <<
+                      std::endl;
+            return {};
+        }
+        statements.push_back(std::move(*a_statement));
+    }
+
+    return statements;
+}
+
+}//namespace psqlxx
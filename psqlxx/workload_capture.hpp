@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace psqlxx {
+
+struct CapturedStatement {
+    // Since the capture began
+    std::int64_t offset_us = 0;
+    std::int64_t duration_us = 0;
+    // Rows returned or affected, -1 if unknown
+    std::int64_t row_count = -1;
+
+    std::string sql;
+};
+
+/**
+ * Records the statements of a session to a capture file, one per line, as tab separated
+ * offset, duration, row count and SQL, which is escaped like COPY text.
+ */
+class WorkloadCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::ofstream m_file;
+    const Clock::time_point m_begin = Clock::now();
+
+public:
+    explicit WorkloadCapture(const std::string &path);
+
+    [[nodiscard]]
+    operator bool() const {
+        return static_cast<bool>(m_file);
+    }
+
+    void Record(const std::string_view sql, const Clock::time_point start,
+                const Clock::time_point end, const std::int64_t row_count);
+};
+
+/**
+ * @return  nullopt after printing the error, if failed to read the file or a line of it.
+ */
+[[nodiscard]]
+std::optional<std::vector<CapturedStatement>> ReadCapture(const std::string &path);
+
+
+namespace internal {
+
+[[nodiscard]]
+std::string formatCapturedStatement(const CapturedStatement &a_statement);
+
+[[nodiscard]]
+std::optional<CapturedStatement> parseCapturedStatement(std::string_view line);
+
+}//namespace internal
+
+}//namespace psqlxx
@@ -0,0 +1,35 @@
+#include <psqlxx/workload_capture.hpp>
+
+#include <gtest/gtest.h>
+
+
+using namespace psqlxx;
+
+
+TEST(CapturedStatementTests, CanFormatAndParse) {
+    const CapturedStatement a_statement{1500, 20, 3, "select 'a\tb',\n'c\\d'\r"};
+    const auto line = internal::formatCapturedStatement(a_statement);
+    ASSERT_EQ("1500\t20\t3\tselect 'a\\tb',\\n'c\\\\d'\\r", line);
+
+    const auto parsed = internal::parseCapturedStatement(line);
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(a_statement.offset_us, parsed->offset_us);
+    ASSERT_EQ(a_statement.duration_us, parsed->duration_us);
+    ASSERT_EQ(a_statement.row_count, parsed->row_count);
+    ASSERT_EQ(a_statement.sql, parsed->sql);
+}
+
+TEST(CapturedStatementTests, CanParseUnknownRowCount) {
+    const auto parsed = internal::parseCapturedStatement("0\t1\t-1\tbegin");
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(-1, parsed->row_count);
+    ASSERT_EQ("begin", parsed->sql);
+}
+
+TEST(CapturedStatementTests, ReturnNulloptIfGivenInvalidLine) {
+    ASSERT_FALSE(internal::parseCapturedStatement("select 1"));
+    ASSERT_FALSE(internal::parseCapturedStatement("1\t2\tselect 1"));
+    ASSERT_FALSE(internal::parseCapturedStatement("1\tx\t0\tselect 1"));
+    ASSERT_FALSE(internal::parseCapturedStatement("1\t2\t0\tselect 1\\"));
+    ASSERT_FALSE(internal::parseCapturedStatement("1\t2\t0\tselect \\x"));
+}